@@ -0,0 +1,37 @@
+#Toolchain for the Onion Omega2 (MT7688, mipsel, musl) using the OpenWrt SDK.
+#Point OMEGA_TOOLCHAIN at the SDK's toolchain directory, for example
+#  cmake -S . -B build-omega -DCMAKE_TOOLCHAIN_FILE=cmake/omega-mips.cmake \
+#    -DOMEGA_TOOLCHAIN=$SDK/staging_dir/toolchain-mipsel_24kc_gcc-7.3.0_musl \
+#    -DOMEGA_SYSROOT=$SDK/staging_dir/target-mipsel_24kc_musl
+set(CMAKE_SYSTEM_NAME Linux)
+set(CMAKE_SYSTEM_PROCESSOR mips)
+
+set(OMEGA_TOOLCHAIN "$ENV{OMEGA_TOOLCHAIN}" CACHE PATH "OpenWrt toolchain directory")
+set(OMEGA_SYSROOT "$ENV{OMEGA_SYSROOT}" CACHE PATH "OpenWrt target staging directory")
+set(OMEGA_TRIPLE "mipsel-openwrt-linux-musl" CACHE STRING "Compiler prefix")
+
+if(OMEGA_TOOLCHAIN)
+  set(CMAKE_CXX_COMPILER ${OMEGA_TOOLCHAIN}/bin/${OMEGA_TRIPLE}-g++)
+  set(CMAKE_C_COMPILER ${OMEGA_TOOLCHAIN}/bin/${OMEGA_TRIPLE}-gcc)
+else()
+  set(CMAKE_CXX_COMPILER ${OMEGA_TRIPLE}-g++)
+  set(CMAKE_C_COMPILER ${OMEGA_TRIPLE}-gcc)
+endif()
+
+set(CMAKE_CXX_FLAGS_INIT "-march=24kc -mtune=24kc")
+
+if(OMEGA_SYSROOT)
+  set(CMAKE_FIND_ROOT_PATH ${OMEGA_SYSROOT})
+  include_directories(SYSTEM ${OMEGA_SYSROOT}/usr/include)
+  link_directories(${OMEGA_SYSROOT}/usr/lib)
+endif()
+set(CMAKE_FIND_ROOT_PATH_MODE_PROGRAM NEVER)
+set(CMAKE_FIND_ROOT_PATH_MODE_LIBRARY ONLY)
+set(CMAKE_FIND_ROOT_PATH_MODE_INCLUDE ONLY)
+
+#Optional user mode emulator (for example qemu-mipsel) so the simulator
+#training run for profile guided builds can run on the host
+set(OMEGA_EMULATOR "$ENV{OMEGA_EMULATOR}" CACHE STRING "Emulator for running target binaries")
+if(OMEGA_EMULATOR)
+  set(CMAKE_CROSSCOMPILING_EMULATOR ${OMEGA_EMULATOR} -L ${OMEGA_SYSROOT})
+endif()
@@ -0,0 +1,74 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+/*
+Board layouts
+--------------
+Which GPIO each sensor and motor is wired to, fixed when building. Every
+pin is its own type, so using a GPIO the backends can't drive, two parts on
+one GPIO, or reading a motor and writing a sensor (see readPin and writePin
+in gpio.h) fail to compile instead of failing on the car. The layout is
+picked with -DOMEGA_BOARD=<name>, see CMakeLists.txt.
+*/
+
+enum PinDirection {
+  pinInput,
+  pinOutput
+};
+
+template <int number, PinDirection way>
+  struct Pin {
+    static_assert(number >= 0 && number < 32, "only GPIOs 0-31 (the first bank) are supported");
+    static constexpr int gpio = number;
+    static constexpr unsigned int mask = 1U << number;
+    static constexpr PinDirection direction = way;
+  };
+
+//The car as built, sensors through the Arduino dock (OMEGA_BOARD=car)
+struct CarBoard {
+  //IR Sensors
+  typedef Pin<11, pinInput> SensorLeft;
+  typedef Pin<19, pinInput> SensorRight;
+  typedef Pin<18, pinInput> SensorFront;
+  //Motors, forward
+  typedef Pin<3, pinOutput> MotorFL;
+  typedef Pin<1, pinOutput> MotorFR;
+  //Motors, reverse
+  typedef Pin<2, pinOutput> MotorRL;
+  typedef Pin<0, pinOutput> MotorRR;
+  //Wheel encoders on spare expansion header pins, see encoder.h
+  typedef Pin<15, pinInput> EncoderLeft;
+  typedef Pin<16, pinInput> EncoderRight;
+};
+
+//Sensors on the expansion header's 15-17, which leaves the hardware PWM
+//pins 18 and 19 free (OMEGA_BOARD=expansion)
+struct ExpansionBoard {
+  typedef Pin<15, pinInput> SensorLeft;
+  typedef Pin<17, pinInput> SensorRight;
+  typedef Pin<16, pinInput> SensorFront;
+  typedef Pin<3, pinOutput> MotorFL;
+  typedef Pin<1, pinOutput> MotorFR;
+  typedef Pin<2, pinOutput> MotorRL;
+  typedef Pin<0, pinOutput> MotorRR;
+  typedef Pin<6, pinInput> EncoderLeft;
+  typedef Pin<7, pinInput> EncoderRight;
+};
+
+#if defined(OMEGA_BOARD_EXPANSION)
+typedef ExpansionBoard Board;
+#else
+typedef CarBoard Board;
+#endif
+
+//Every pin the board uses, nothing configured at run time may take these
+constexpr unsigned int boardPinMask = Board::SensorLeft::mask | Board::SensorRight::mask | Board::SensorFront::mask | Board::MotorFL::mask | Board::MotorFR::mask | Board::MotorRL::mask | Board::MotorRR::mask
+    | Board::EncoderLeft::mask | Board::EncoderRight::mask;
+
+//Two parts on one GPIO would make the sum of the masks differ from the or
+static_assert(boardPinMask
+  == Board::SensorLeft::mask + Board::SensorRight::mask + Board::SensorFront::mask + Board::MotorFL::mask + Board::MotorFR::mask + Board::MotorRL::mask + Board::MotorRR::mask
+    + Board::EncoderLeft::mask + Board::EncoderRight::mask,
+  "two parts of the board share a GPIO");
+
+#endif
@@ -0,0 +1,203 @@
+#include <cstdio> //For reading and writing the config file
+#include <cstring> //For strcmp
+#include <ctime> //For clock_nanosleep
+#include "calibration.h"
+#include "motion.h"
+#include "sensors.h"
+#include "metrics.h"
+#include "logging.h"
+#include "tuning.h"
+#include "watchdog.h"
+
+long turnMicros[3] = { 4000000, 2000000, 2000000 };
+long halfPathMicros = 150000;
+
+//Path crossings timed per direction while calibrating, each is half a turn
+const int calibrationCrossings = 4;
+//Give up if the path isn't found for this long
+const long calibrationTimeoutMicros = 10000000;
+//learnTurn moves 1/learnShare of the way to each estimate, and ignores
+//estimates more than 1/learnLimit away (probably a different path)
+const int learnShare = 8;
+const int learnLimit = 4;
+
+Result<void> loadTurnCalibration(const char *path) {
+  FILE *in = fopen(path, "r");
+  if(!in) {
+    return errFileRead;
+  }
+  char line[128];
+  char name[32];
+  long micros;
+  while(fgets(line, sizeof(line), in)) {
+    if(line[0] == '#' || sscanf(line, "%31s %ld", name, &micros) != 2 || micros <= 0) {
+      continue;
+    }
+    if(!strcmp(name, "around")) {
+      turnMicros[0] = micros;
+    }
+    else if(!strcmp(name, "left90")) {
+      turnMicros[1] = micros;
+    }
+    else if(!strcmp(name, "right90")) {
+      turnMicros[2] = micros;
+    }
+    else if(!strcmp(name, "halfPath")) {
+      halfPathMicros = micros;
+    }
+  }
+  fclose(in);
+  return Result<void>();
+}
+
+Result<void> saveTurnCalibration(const char *path) {
+  FILE *out = fopen(path, "w");
+  if(!out) {
+    return errFileWrite;
+  }
+  fprintf(out, "# Full speed turn times in microseconds, see calibration.h\n");
+  fprintf(out, "left90 %ld\nright90 %ld\naround %ld\nhalfPath %ld\n", turnMicros[1], turnMicros[2], turnMicros[0], halfPathMicros);
+  if(fclose(out)) {
+    return errFileWrite;
+  }
+  return Result<void>();
+}
+
+/*
+spinCrossings:
+  Spins at full speed and times calibrationCrossings path crossings after the
+  first one. Gives the time per crossing and how long the path was under the
+  front sensor.
+*/
+static Result<void> spinCrossings(MotorCommand command, long &crossingMicros, long &pathMicros) {
+  const char *inFunction = "spinCrossings";
+  Result<void> motors = retry(tuning().gpioRetry, [command]() { return applyMotors(command); });
+  if(!motors.ok()) {
+    errMsg(motors.getError(), inFunction, " - failed to set motor states.");
+    return motors.getError();
+  }
+  unsigned long start = metricsNowMicros();
+  unsigned long firstFound = 0;
+  unsigned long lastFound = 0;
+  unsigned long onPath = 0;
+  int crossings = -1;
+  bool path = true;
+  ErrorCode error = errNone;
+  timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  while(crossings < calibrationCrossings) {
+    unsigned long now = metricsNowMicros();
+    if(now - start > calibrationTimeoutMicros) {
+      error = errStuck;
+      break;
+    }
+    if(!kickWatchdog()) {
+      error = errWatchdog;
+      break;
+    }
+    Result<bool> front = checkIR(0);
+    if(!front.ok()) {
+      error = front.getError();
+      break;
+    }
+    if(path && !front.get()) {
+      if(crossings >= 0) {
+        onPath += now - lastFound;
+      }
+    }
+    else if(!path && front.get()) {
+      crossings ++;
+      lastFound = now;
+      if(!crossings) {
+        firstFound = now;
+      }
+    }
+    path = front.get();
+    next.tv_nsec += motionTickMicros * 1000;
+    if(next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec ++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  motors = retry(tuning().gpioRetry, []() { return applyMotors(motorsStop); });
+  if(error != errNone) {
+    errMsg(error, inFunction, " - did not find the path while spinning.");
+    return error;
+  }
+  if(!motors.ok()) {
+    errMsg(motors.getError(), inFunction, " - failed to stop the motors.");
+    return motors.getError();
+  }
+  crossingMicros = (lastFound - firstFound) / calibrationCrossings;
+  pathMicros = onPath / calibrationCrossings;
+  return Result<void>();
+}
+
+Result<void> calibrateTurns() {
+  const char *inFunction = "calibrateTurns";
+  writeToLog(inFunction, 0, "");
+  long leftCrossing, rightCrossing, leftPath, rightPath;
+  Result<void> spun = spinCrossings(motorsTurnLeft, leftCrossing, leftPath);
+  if(spun.ok()) {
+    spun = spinCrossings(motorsTurnRight, rightCrossing, rightPath);
+  }
+  if(!spun.ok()) {
+    return spun;
+  }
+  //A crossing is half a turn, and the car turns around to the left
+  turnMicros[0] = leftCrossing;
+  turnMicros[1] = leftCrossing / 2;
+  turnMicros[2] = rightCrossing / 2;
+  halfPathMicros = (leftPath + rightPath) / 4;
+  writeToLog(inFunction, 1, "");
+  return Result<void>();
+}
+
+/*
+nudgeTurn:
+  Moves a turn time part of the way to a new estimate, unless the estimate
+  is too far off to trust
+*/
+static void nudgeTurn(int turnDirection, long estimate) {
+  long current = turnMicros[turnDirection];
+  long difference = estimate - current;
+  if(difference > current / learnLimit || difference < -current / learnLimit) {
+    return;
+  }
+  turnMicros[turnDirection] = current + difference / learnShare;
+
+  char toLog[64];
+  char *spot = appendText(toLog, toLog + sizeof(toLog) - 1, "Turn estimate: ");
+  spot = numberToChars(spot, toLog + sizeof(toLog) - 4, estimate);
+  spot = appendText(spot, toLog + sizeof(toLog) - 1, " us");
+  *spot = '\0';
+  writeToLog(toLog, 4, "");
+}
+
+void learnTurn(int turnDirection, int lostTicks, int foundTicks) {
+  if(turnDirection < 0 || turnDirection > 2 || foundTicks < 0) {
+    return;
+  }
+  //Starting on a path, losing it took half the path's width
+  if(lostTicks > 0) {
+    halfPathMicros += ((long)lostTicks * motionTickMicros - halfPathMicros) / learnShare;
+  }
+  //The turn should end with the sensor in the middle of the new path
+  nudgeTurn(turnDirection, (long)foundTicks * motionTickMicros + halfPathMicros);
+}
+
+void learnTurnAngle(int turnDirection, long degrees) {
+  if(turnDirection < 0 || turnDirection > 2) {
+    return;
+  }
+  if(degrees < 0) {
+    degrees = -degrees;
+  }
+  if(!degrees) {
+    return;
+  }
+  //The time scales with the angle turned
+  long wanted = turnDirection ? 90 : 180;
+  nudgeTurn(turnDirection, (long long)turnMicros[turnDirection] * wanted / degrees);
+}
@@ -0,0 +1,41 @@
+#ifndef CALIBRATION_H
+#define CALIBRATION_H
+
+#include "result.h"
+
+/*
+Turn calibration
+-----------------
+How long each turn takes at full speed depends on the battery and the floor,
+so the times are measured instead of fixed. `carMaze calibrate` spins the car
+on a straight path through its center and times how often the front sensor
+finds the path again (twice per rotation). The results go to a config file
+read at startup, and every turn after that nudges them toward how far the
+car actually had to turn to find the new path, or how far the wheel
+encoders say it turned.
+
+Config file lines are `<name> <microseconds>` with names left90, right90,
+around and halfPath, # starts a comment.
+*/
+
+//Full speed turn times, indexed by turn direction (0 around, 1 left, 2 right)
+extern long turnMicros[3];
+//Full speed time for the front sensor to cross half of a path
+extern long halfPathMicros;
+
+//Fails with errFileRead if the file could not be read, the defaults are
+//kept for anything missing
+Result<void> loadTurnCalibration(const char *path);
+//Fails with errFileWrite
+Result<void> saveTurnCalibration(const char *path);
+//Spins both ways and sets turnMicros and halfPathMicros. The car has to sit
+//with its front sensor on a straight path.
+Result<void> calibrateTurns();
+//Updates the estimate for a turn from the ticks the front sensor took to
+//lose its path and find the next one (see runProfile)
+void learnTurn(int turnDirection, int lostTicks, int foundTicks);
+//Updates the estimate for a turn from the angle the wheel encoders measured
+//(see encoder.h), used instead of learnTurn when they are running
+void learnTurnAngle(int turnDirection, long degrees);
+
+#endif
@@ -0,0 +1,205 @@
+#include <cstdio> //For the sysfs paths
+#include <fcntl.h> //For open
+#include <poll.h> //For waiting on edges
+#include <pthread.h> //For the reader thread
+#include <sched.h> //For SCHED_FIFO
+#include <unistd.h> //For read, write and close
+#include "encoder.h"
+#include "gpio.h"
+#include "metrics.h"
+#include "logging.h"
+
+std::atomic<long> encoderTicks[2];
+//+1 or -1, which way the last motor command drove each wheel
+static std::atomic<int> wheelSign[2];
+static std::atomic<bool> stopReader;
+static bool running = false;
+static pthread_t readerThread;
+//How long a wait for edges lasts before checking whether to stop
+const int encoderPollMillis = 100;
+
+#ifndef OMEGA_GPIO_SIM
+//Open sysfs value files of the two pins, left then right
+static int valueFiles[2] = { -1, -1 };
+
+/*
+writeSysfs:
+  Writes text to a sysfs file, returns false if it can't
+*/
+static bool writeSysfs(const char *path, const char *text) {
+  int fd = open(path, O_WRONLY);
+  if(fd < 0) {
+    return false;
+  }
+  int length = 0;
+  while(text[length]) {
+    length ++;
+  }
+  bool written = write(fd, text, length) == length;
+  close(fd);
+  return written;
+}
+
+/*
+openEdgePin:
+  Exports a pin through sysfs (whichever GPIO backend is in use), sets it to
+  interrupt on both edges and opens its value file for poll
+*/
+static int openEdgePin(int gpio) {
+  char path[64];
+  char number[8];
+  snprintf(number, sizeof(number), "%d", gpio);
+  snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value", gpio);
+  if(access(path, F_OK) < 0) {
+    writeSysfs("/sys/class/gpio/export", number);
+  }
+  snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/direction", gpio);
+  if(!writeSysfs(path, "in")) {
+    return -1;
+  }
+  snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/edge", gpio);
+  if(!writeSysfs(path, "both")) {
+    return -1;
+  }
+  snprintf(path, sizeof(path), "/sys/class/gpio/gpio%d/value", gpio);
+  int fd = open(path, O_RDONLY);
+  if(fd >= 0) {
+    //Reading once clears the edge that is already pending
+    char value[4];
+    read(fd, value, sizeof(value));
+  }
+  return fd;
+}
+#endif
+
+/*
+waitEdges:
+  Waits up to encoderPollMillis for edges, returns which wheels had one
+  (bit n for wheel n)
+*/
+static unsigned int waitEdges() {
+#ifdef OMEGA_GPIO_SIM
+  unsigned int pins = simWaitEdges(encoderPollMillis);
+  return (pins & Board::EncoderLeft::mask ? 1U << encoderLeft : 0) | (pins & Board::EncoderRight::mask ? 1U << encoderRight : 0);
+#else
+  pollfd waiting[2];
+  for(int i = 0; i < 2; i++) {
+    waiting[i].fd = valueFiles[i];
+    waiting[i].events = POLLPRI | POLLERR;
+    waiting[i].revents = 0;
+  }
+  if(poll(waiting, 2, encoderPollMillis) <= 0) {
+    return 0;
+  }
+  unsigned int wheels = 0;
+  for(int i = 0; i < 2; i++) {
+    if(waiting[i].revents & (POLLPRI | POLLERR)) {
+      char value[4];
+      lseek(valueFiles[i], 0, SEEK_SET);
+      read(valueFiles[i], value, sizeof(value));
+      wheels |= 1U << i;
+    }
+  }
+  return wheels;
+#endif
+}
+
+/*
+readEncoders:
+  Reader thread. Counts every edge the way its wheel is being driven.
+  Asks for a real time priority above the control loop's so edges are
+  counted as they come, and carries on at normal priority without it.
+*/
+static void *readEncoders(void *) {
+  sched_param param;
+  param.sched_priority = 1;
+  pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+  while(!stopReader.load(std::memory_order_relaxed)) {
+    unsigned int wheels = waitEdges();
+    for(int i = 0; i < 2; i++) {
+      if(wheels & (1U << i)) {
+        encoderTicks[i].fetch_add(wheelSign[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+        encoderEdges.add(1);
+      }
+    }
+  }
+  return NULL;
+}
+
+Result<void> startEncoders() {
+  const char *inFunction = "startEncoders";
+  if(running) {
+    return Result<void>();
+  }
+  encoderTicks[encoderLeft].store(0, std::memory_order_relaxed);
+  encoderTicks[encoderRight].store(0, std::memory_order_relaxed);
+  encoderDrive(motorsForward);
+#ifndef OMEGA_GPIO_SIM
+  valueFiles[encoderLeft] = openEdgePin(Board::EncoderLeft::gpio);
+  valueFiles[encoderRight] = openEdgePin(Board::EncoderRight::gpio);
+  if(valueFiles[encoderLeft] < 0 || valueFiles[encoderRight] < 0) {
+    warnMsg(errGpioRequest, inFunction, " - could not set up the encoder pins, distances come from timing.");
+    stopEncoders();
+    return errGpioRequest;
+  }
+#endif
+  stopReader.store(false, std::memory_order_relaxed);
+  if(pthread_create(&readerThread, NULL, readEncoders, NULL) != 0) {
+    warnMsg(errThread, inFunction, " - could not start the encoder thread.");
+    stopEncoders();
+    return errThread;
+  }
+  running = true;
+  return Result<void>();
+}
+
+void stopEncoders() {
+  if(running) {
+    stopReader.store(true, std::memory_order_relaxed);
+    pthread_join(readerThread, NULL);
+    running = false;
+  }
+#ifndef OMEGA_GPIO_SIM
+  for(int i = 0; i < 2; i++) {
+    if(valueFiles[i] >= 0) {
+      close(valueFiles[i]);
+      valueFiles[i] = -1;
+    }
+  }
+#endif
+}
+
+bool encodersRunning() {
+  return running;
+}
+
+void encoderDrive(MotorCommand command) {
+  //Stopping leaves the signs alone, the wheels still roll the same way
+  switch(command) {
+    case motorsForward:
+      wheelSign[encoderLeft].store(1, std::memory_order_relaxed);
+      wheelSign[encoderRight].store(1, std::memory_order_relaxed);
+      break;
+    case motorsTurnLeft:
+      wheelSign[encoderLeft].store(-1, std::memory_order_relaxed);
+      wheelSign[encoderRight].store(1, std::memory_order_relaxed);
+      break;
+    case motorsTurnRight:
+      wheelSign[encoderLeft].store(1, std::memory_order_relaxed);
+      wheelSign[encoderRight].store(-1, std::memory_order_relaxed);
+      break;
+    case motorsStop:
+      break;
+  }
+}
+
+long encoderDistanceMm() {
+  long ticks = encoderTicks[encoderLeft].load(std::memory_order_relaxed) + encoderTicks[encoderRight].load(std::memory_order_relaxed);
+  return ticks * wheelCircumferenceMm / (2 * encoderEdgesPerTurn);
+}
+
+long encoderAngleDegrees() {
+  long ticks = encoderTicks[encoderRight].load(std::memory_order_relaxed) - encoderTicks[encoderLeft].load(std::memory_order_relaxed);
+  //The difference in mm over the wheel base is the angle in radians
+  return (long long)ticks * wheelCircumferenceMm * 180000 / ((long long)encoderEdgesPerTurn * wheelBaseMm * 3142);
+}
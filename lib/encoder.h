@@ -0,0 +1,48 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <atomic>
+#include "motors.h"
+
+/*
+Wheel encoders
+---------------
+A slotted disc and an optical sensor on each side's wheel, one pin each
+(Board::EncoderLeft and EncoderRight). A reader thread waits for edges on
+both pins (poll on the sysfs value files, or pulses made up by the simulator
+from the motor pins) and counts them into relaxed atomic counters, so the
+control loop reads how far the car went without locking or waiting. One
+pin can't tell which way the wheel turns, so each edge counts the way the
+last motor command drove that wheel.
+
+Without encoders (startEncoders fails) distances stay 0 and everything
+falls back to timing.
+*/
+
+//Edges per wheel turn (20 slots, both edges) and how far that rolls
+const int encoderEdgesPerTurn = 40;
+const int wheelCircumferenceMm = 204;
+//Between the middles of the left and right wheels
+const int wheelBaseMm = 130;
+
+enum EncoderWheel {
+  encoderLeft,
+  encoderRight
+};
+//Signed edge counts per wheel, forward is positive
+extern std::atomic<long> encoderTicks[2];
+
+//Starts the reader thread. Fails with errGpioRequest or errThread if the pins
+//or thread could not be set up.
+Result<void> startEncoders();
+void stopEncoders();
+//Whether the reader thread is counting
+bool encodersRunning();
+//Tells the counters which way each wheel is being driven
+void encoderDrive(MotorCommand command);
+//Distance in mm the middle of the car has rolled, forward positive
+long encoderDistanceMm();
+//Degrees the car has turned, left (anticlockwise) positive
+long encoderAngleDegrees();
+
+#endif
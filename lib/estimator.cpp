@@ -0,0 +1,121 @@
+#include "estimator.h"
+#include "encoder.h"
+#include "calibration.h"
+#include "motion.h"
+#include "trace.h"
+
+Estimate estimate;
+
+//Variance added per mm or degree the motor model moves the estimate
+//(fixed point), how far it can be trusted to predict
+const long distanceDrift = 26; //0.1 mm squared per mm
+const long headingDrift = 128; //0.5 degrees squared per degree turned
+const long headingDriftStraight = 3; //Per mm driven straight
+//Measurement variances, fixed point
+const long encoderDistanceNoise = 16L << estimateShift;
+const long encoderHeadingNoise = 16L << estimateShift;
+
+//Encoder readings when the estimate was reset, and the heading then
+static long encoderDistanceBase;
+static long encoderAngleBase;
+static long encoderHeadingBase;
+//The turn in progress, see estimatorStartTurn
+static int turning = -1;
+static long turnSign;
+static long turnStart;
+static long turnTarget;
+static long fullTurnRate;
+
+/*
+measure:
+  Kalman update of one state from a measurement with variance noise
+*/
+static void measure(long &value, long &variance, long measured, long noise) {
+  long long total = (long long)variance + noise;
+  if(total <= 0) {
+    return;
+  }
+  value += (long long)(measured - value) * variance / total;
+  variance = (long long)variance * noise / total;
+}
+
+void estimatorReset(int heading) {
+  estimate.distance = 0;
+  estimate.distanceVariance = 0;
+  estimate.heading = (long)heading << estimateShift;
+  estimate.headingVariance = 0;
+  estimate.speed = 0;
+  estimate.turnRate = 0;
+  encoderDistanceBase = encoderDistanceMm();
+  encoderAngleBase = encoderAngleDegrees();
+  encoderHeadingBase = estimate.heading;
+  turning = -1;
+}
+
+void estimatorPredict(MotorCommand command, int duty, long dtMicros) {
+  TraceScope trace(traceEstimator);
+  //Where the motor model says the speeds are heading
+  long targetSpeed = 0, targetRate = 0;
+  if(command == motorsForward) {
+    targetSpeed = (fullSpeedMmPerSecond << estimateShift) * duty / pwmSteps;
+  }
+  else if(command != motorsStop && turning >= 0) {
+    targetRate = turnSign * fullTurnRate * duty / pwmSteps;
+  }
+  long lag = dtMicros < motorLagMicros ? dtMicros : motorLagMicros;
+  estimate.speed += (long long)(targetSpeed - estimate.speed) * lag / motorLagMicros;
+  estimate.turnRate += (long long)(targetRate - estimate.turnRate) * lag / motorLagMicros;
+
+  //Predict, the variance growing with how far the prediction went
+  long moved = (long long)estimate.speed * dtMicros / 1000000;
+  long turned = (long long)estimate.turnRate * dtMicros / 1000000;
+  estimate.distance += moved;
+  estimate.heading += turned;
+  moved = moved < 0 ? -moved : moved;
+  turned = turned < 0 ? -turned : turned;
+  estimate.distanceVariance += (long long)moved * distanceDrift >> estimateShift;
+  estimate.headingVariance += ((long long)turned * headingDrift + (long long)moved * headingDriftStraight) >> estimateShift;
+
+  if(encodersRunning()) {
+    measure(estimate.distance, estimate.distanceVariance, (encoderDistanceMm() - encoderDistanceBase) << estimateShift, encoderDistanceNoise);
+    //The encoders count left turns as positive
+    measure(estimate.heading, estimate.headingVariance, encoderHeadingBase - ((encoderAngleDegrees() - encoderAngleBase) << estimateShift), encoderHeadingNoise);
+  }
+}
+
+void estimatorStartTurn(int turnDirection) {
+  if(turnDirection < 0 || turnDirection > 2) {
+    return;
+  }
+  //Turning around is a long left turn
+  turning = turnDirection;
+  turnSign = turnDirection == 2 ? 1 : -1;
+  long degrees = turnDirection ? 90 : 180;
+  turnStart = estimate.heading;
+  turnTarget = turnStart + turnSign * (degrees << estimateShift);
+  fullTurnRate = (degrees << estimateShift) * 1000000LL / turnMicros[turnDirection];
+}
+
+void estimatorSeeLine(bool found) {
+  if(turning < 0) {
+    return;
+  }
+  //The sensor is half a path away from the middle of the line it is on
+  long halfPath = (long long)fullTurnRate * halfPathMicros / 1000000;
+  long noise = ((long long)halfPath * halfPath >> estimateShift) / 4 + 1;
+  if(!found) {
+    measure(estimate.heading, estimate.headingVariance, turnStart + turnSign * halfPath, noise);
+  }
+  else if(turning) {
+    //Turning around can find a side path first, so only 90s are trusted
+    measure(estimate.heading, estimate.headingVariance, turnTarget - turnSign * halfPath, noise);
+  }
+}
+
+long estimatedDistanceMm() {
+  return estimate.distance >> estimateShift;
+}
+
+long estimatedHeadingDegrees() {
+  return estimate.heading >> estimateShift;
+}
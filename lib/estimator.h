@@ -0,0 +1,58 @@
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+#include "motors.h"
+
+/*
+State estimator
+----------------
+Best guess of how far the car has driven and which way it faces, from
+everything that says something about it: the motor commands and their PWM
+duty (odometry through a simple motor model), the wheel encoders when they
+are running, and the front sensor losing and finding the line during turns.
+
+Each of distance and heading is a one state Kalman filter. The motor model
+predicts the change every control tick and the variance grows with how far
+the prediction moved; encoder readings and line edges are measurements that
+pull the estimate in by the usual gain P / (P + R). Everything is fixed
+point (1/256 of a mm or degree, 64 bit products) since the Omega's MIPS core
+has no FPU, so an update is a handful of multiplies and at most two
+divides. Build with -DOMEGA_TRACE=ON to see what it costs (estimatorPredict
+in trace.txt), or time the prediction on its own with tools/estimatorBench.
+
+Headings are compass degrees like the directions in maze.h: 0 north,
+clockwise positive, not wrapped.
+*/
+
+//Fractional bits of every fixed point value
+const int estimateShift = 8;
+//Full speed of the car going straight, and how quickly the speed follows
+//the duty
+const long fullSpeedMmPerSecond = 300;
+const long motorLagMicros = 50000;
+
+struct Estimate {
+  long distance; //mm driven forward, fixed point
+  long distanceVariance; //mm squared, fixed point
+  long heading; //Degrees, fixed point
+  long headingVariance; //Degrees squared, fixed point
+  long speed; //mm per second, fixed point, from the motor model
+  long turnRate; //Degrees per second clockwise, fixed point
+};
+extern Estimate estimate;
+
+//Starts again at distance 0 facing heading degrees, and is certain of it
+void estimatorReset(int heading);
+//Moves the estimate on by dtMicros of command at duty (out of pwmSteps) and
+//takes in the wheel encoders when they are running. Called every control
+//tick by runProfile and driveUpdate.
+void estimatorPredict(MotorCommand command, int duty, long dtMicros);
+//A turn (as in motors.h) is starting, for estimatorSeeLine
+void estimatorStartTurn(int turnDirection);
+//The front sensor lost (found false) or found the line during the turn
+void estimatorSeeLine(bool found);
+//Whole mm and degrees
+long estimatedDistanceMm();
+long estimatedHeadingDegrees();
+
+#endif
@@ -0,0 +1,278 @@
+#include "frontier.h"
+#include "sensors.h"
+
+void frontierReset(FrontierIndex &index) {
+  index.nodeCount = 0;
+  index.frontier = 0;
+  index.current = -1;
+  index.created = false;
+  index.leftBy = -1;
+  index.leftAt = 0;
+  index.routeLength = 0;
+  index.routeStep = 0;
+}
+
+/*
+updateFrontier:
+  Sets the frontier bit of a node from its exits
+*/
+static void updateFrontier(FrontierIndex &index, int node) {
+  const FrontierNode &entry = index.nodes[node];
+  bool open = false;
+  for(int i = 0; i < 4; i++) {
+    open = open || entry.exits[i] == exitOpen;
+  }
+  if(open) {
+    index.frontier |= 1ULL << node;
+  }
+  else {
+    index.frontier &= ~(1ULL << node);
+  }
+}
+
+/*
+setExit:
+  Changes an exit and keeps the frontier bit of its node right
+*/
+static void setExit(FrontierIndex &index, int node, int direction, ExitState state) {
+  index.nodes[node].exits[direction] = state;
+  updateFrontier(index, node);
+}
+
+/*
+seeExit:
+  What the sensors say about an exit, only used when it isn't known yet
+*/
+static void seeExit(FrontierIndex &index, int node, int direction, bool path) {
+  if(index.nodes[node].exits[direction] == exitUnknown) {
+    setExit(index, node, direction, path ? exitOpen : exitWall);
+  }
+}
+
+void frontierArrive(FrontierIndex &index, int heading, unsigned int paths, unsigned long now) {
+  int from = index.current;
+  int fromBy = index.leftBy;
+  int back = (heading + 2) % 4;
+  int node = from >= 0 && fromBy >= 0 ? index.nodes[from].to[fromBy] : -1;
+  index.created = false;
+  if(node < 0) {
+    //Somewhere new
+    if(index.nodeCount == frontierMaxNodes) {
+      index.current = -1;
+      index.created = false;
+      index.leftBy = -1;
+      index.routeLength = 0;
+      return;
+    }
+    node = index.nodeCount++;
+    index.created = true;
+    FrontierNode &entry = index.nodes[node];
+    for(int i = 0; i < 4; i++) {
+      entry.exits[i] = exitUnknown;
+      entry.to[i] = -1;
+      entry.length[i] = 0;
+    }
+  }
+  //The corridor just driven, both ways
+  FrontierNode &entry = index.nodes[node];
+  setExit(index, node, back, exitDriven);
+  if(from >= 0 && fromBy >= 0) {
+    unsigned long length = now - index.leftAt;
+    entry.to[back] = from;
+    entry.length[back] = length;
+    index.nodes[from].to[fromBy] = node;
+    index.nodes[from].length[fromBy] = length;
+  }
+  seeExit(index, node, heading, paths & irFrontPath);
+  seeExit(index, node, (heading + 3) % 4, paths & irLeftPath);
+  seeExit(index, node, (heading + 1) % 4, paths & irRightPath);
+  index.current = node;
+  index.leftBy = -1;
+}
+
+int frontierBearing(const FrontierIndex &index, int heading, unsigned int paths) {
+  if(!frontierRouting(index)) {
+    return -1;
+  }
+  //Relative to the heading: 0 ahead, 1 right, 2 behind, 3 left
+  switch((index.route[index.routeStep] - heading + 4) % 4) {
+    case 0:
+      return paths & irFrontPath ? 0 : -1;
+    case 1:
+      return paths & irRightPath ? 2 : -1;
+    case 3:
+      return paths & irLeftPath ? 1 : -1;
+    default:
+      return 3;
+  }
+}
+
+/*
+Heap:
+  Smallest distance on top, for frontierPlan
+*/
+struct HeapEntry {
+  unsigned long distance;
+  int node;
+};
+struct Heap {
+  //Every node can be pushed once per corridor into it
+  HeapEntry entries[frontierMaxNodes * 4];
+  int size;
+  void push(unsigned long distance, int node) {
+    int spot = size++;
+    while(spot && entries[(spot - 1) / 2].distance > distance) {
+      entries[spot] = entries[(spot - 1) / 2];
+      spot = (spot - 1) / 2;
+    }
+    entries[spot].distance = distance;
+    entries[spot].node = node;
+  }
+  HeapEntry pop() {
+    HeapEntry top = entries[0];
+    HeapEntry last = entries[--size];
+    int spot = 0;
+    while(spot * 2 + 1 < size) {
+      int child = spot * 2 + 1;
+      if(child + 1 < size && entries[child + 1].distance < entries[child].distance) {
+        child ++;
+      }
+      if(entries[child].distance >= last.distance) {
+        break;
+      }
+      entries[spot] = entries[child];
+      spot = child;
+    }
+    entries[spot] = last;
+    return top;
+  }
+};
+
+int frontierPlan(FrontierIndex &index) {
+  index.routeLength = 0;
+  index.routeStep = 0;
+  int start = index.current;
+  if(start < 0 || !(index.frontier & ~(1ULL << start))) {
+    return -1;
+  }
+  static Heap heap;
+  unsigned long distance[frontierMaxNodes];
+  signed char cameBy[frontierMaxNodes]; //Direction taken out of the previous node
+  signed char previous[frontierMaxNodes];
+  bool done[frontierMaxNodes] = { false };
+  for(int node = 0; node < index.nodeCount; node++) {
+    distance[node] = ~0UL;
+    previous[node] = -1;
+  }
+  heap.size = 0;
+  distance[start] = 0;
+  heap.push(0, start);
+  int goal = -1;
+  while(heap.size) {
+    HeapEntry top = heap.pop();
+    if(done[top.node]) {
+      continue;
+    }
+    done[top.node] = true;
+    if(top.node != start && (index.frontier & (1ULL << top.node))) {
+      goal = top.node;
+      break;
+    }
+    const FrontierNode &entry = index.nodes[top.node];
+    for(int direction = 0; direction < 4; direction++) {
+      int next = entry.to[direction];
+      if(entry.exits[direction] != exitDriven || next < 0) {
+        continue;
+      }
+      //Count every corridor as at least 1 so ties go to fewer corridors
+      unsigned long through = top.distance + (entry.length[direction] ? entry.length[direction] : 1);
+      if(through < distance[next]) {
+        distance[next] = through;
+        previous[next] = top.node;
+        cameBy[next] = direction;
+        heap.push(through, next);
+      }
+    }
+  }
+  if(goal < 0) {
+    return -1;
+  }
+  //Walk back from the goal, then turn the directions around
+  int length = 0;
+  for(int node = goal; node != start; node = previous[node]) {
+    index.route[length++] = cameBy[node];
+  }
+  for(int i = 0; i < length / 2; i++) {
+    signed char swap = index.route[i];
+    index.route[i] = index.route[length - 1 - i];
+    index.route[length - 1 - i] = swap;
+  }
+  index.routeLength = length;
+  return length - 1;
+}
+
+void frontierLeave(FrontierIndex &index, int heading, unsigned long now) {
+  if(frontierRouting(index)) {
+    if(index.route[index.routeStep] == heading) {
+      index.routeStep ++;
+    }
+    else {
+      //Went another way, the route no longer means anything
+      index.routeLength = 0;
+      index.routeStep = 0;
+    }
+  }
+  if(index.current < 0) {
+    return;
+  }
+  FrontierNode &entry = index.nodes[index.current];
+  if(entry.exits[heading] != exitDriven) {
+    setExit(index, index.current, heading, exitDriven);
+  }
+  index.leftBy = heading;
+  index.leftAt = now;
+}
+
+void frontierMerge(FrontierIndex &index, int keep, int drop) {
+  if(keep == drop || keep < 0 || drop < 0) {
+    return;
+  }
+  for(int node = 0; node < index.nodeCount; node++) {
+    for(int direction = 0; direction < 4; direction++) {
+      if(index.nodes[node].to[direction] == drop) {
+        index.nodes[node].to[direction] = keep;
+      }
+    }
+  }
+  FrontierNode &kept = index.nodes[keep];
+  FrontierNode &dropped = index.nodes[drop];
+  for(int direction = 0; direction < 4; direction++) {
+    if(dropped.exits[direction] == exitDriven && kept.exits[direction] != exitDriven) {
+      kept.exits[direction] = exitDriven;
+      kept.to[direction] = dropped.to[direction];
+      kept.length[direction] = dropped.length[direction];
+    }
+    else if(kept.exits[direction] == exitUnknown) {
+      kept.exits[direction] = dropped.exits[direction];
+    }
+    dropped.exits[direction] = exitWall;
+    dropped.to[direction] = -1;
+  }
+  updateFrontier(index, keep);
+  updateFrontier(index, drop);
+  if(index.current == drop) {
+    index.current = keep;
+  }
+  index.routeLength = 0;
+  index.routeStep = 0;
+}
+
+unsigned int frontierExitMask(const FrontierIndex &index, int node) {
+  unsigned int mask = 0;
+  for(int direction = 0; direction < 4; direction++) {
+    if(index.nodes[node].exits[direction] == exitOpen || index.nodes[node].exits[direction] == exitDriven) {
+      mask |= 1U << direction;
+    }
+  }
+  return mask;
+}
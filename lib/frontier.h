@@ -0,0 +1,75 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+/*
+Frontier index
+---------------
+A graph of the intersections the car has been to, built as it goes: each
+node keeps, per direction (0 north to 3 west), whether there is a wall, a
+path nobody has driven down yet, or a corridor to a known node and how long
+it is. Nodes with a path not yet driven are the frontier, kept as a bit
+set that is updated whenever an exit changes.
+
+When Tremaux turns the car around, frontierPlan finds the closest frontier
+node along known corridors (Dijkstra on a small heap) and frontierBearing
+then steers every intersection on the way, instead of backtracking one
+decision at a time. Nodes are told apart by the corridor the car arrived
+through, so the graph follows the car's own idea of where it is.
+
+Corridor lengths are in whatever unit the caller passes (time, or distance
+from the wheel encoders), as long as it is the same.
+*/
+
+const int frontierMaxNodes = 64;
+const int frontierMaxRoute = frontierMaxNodes;
+
+enum ExitState {
+  exitUnknown,
+  exitWall,
+  exitOpen, //A path nobody has driven down
+  exitDriven
+};
+
+struct FrontierNode {
+  unsigned char exits[4]; //ExitState per direction
+  signed char to[4]; //Node at the other end, -1 if not known
+  unsigned long length[4];
+};
+
+struct FrontierIndex {
+  FrontierNode nodes[frontierMaxNodes];
+  int nodeCount;
+  unsigned long long frontier; //Bit n set when node n has an exitOpen
+  int current; //Node the car is at or just left, -1 for none
+  bool created; //current was new on arriving
+  int leftBy; //Direction the car left current by, -1 if it hasn't
+  unsigned long leftAt;
+  //Directions to take at the next intersections
+  signed char route[frontierMaxRoute];
+  int routeLength;
+  int routeStep;
+};
+
+void frontierReset(FrontierIndex &index);
+//Arrived at an intersection heading this way, with paths as checkAllIR bits
+void frontierArrive(FrontierIndex &index, int heading, unsigned int paths, unsigned long now);
+//Bearing (as in maze.h) the route wants at this intersection, -1 if there
+//is no route or it can't be followed with these paths
+int frontierBearing(const FrontierIndex &index, int heading, unsigned int paths);
+//Plans a route from the current node to the nearest frontier node. Returns
+//the number of intersections on it (after this one), -1 if there is none.
+int frontierPlan(FrontierIndex &index);
+//Leaving the current intersection heading this way
+void frontierLeave(FrontierIndex &index, int heading, unsigned long now);
+//Folds node drop into keep when both turn out to be the same intersection.
+//Every corridor to drop then leads to keep, and drop is left unreachable.
+//The route is dropped since it may go through either.
+void frontierMerge(FrontierIndex &index, int keep, int drop);
+//Compass directions with a path at a node, bit n for direction n
+unsigned int frontierExitMask(const FrontierIndex &index, int node);
+//Whether a route is being followed
+inline bool frontierRouting(const FrontierIndex &index) {
+  return index.routeStep < index.routeLength;
+}
+
+#endif
@@ -0,0 +1,101 @@
+#include <fcntl.h> //For open
+#include <unistd.h> //For write and close
+#include "gpio.h"
+#include "metrics.h"
+#include "trace.h"
+
+Result<int> readPin(int pin) {
+  TraceScope trace(traceReadPin);
+  int value = gpio_get_value(pin);
+  if(value < 0) {
+    gpioErrors.add(1);
+    return errGpioRead;
+  }
+  return value;
+}
+
+Result<void> writePin(int pin, int value) {
+  TraceScope trace(traceWritePin);
+  tracePin(pin, value);
+  if(gpio_set_value(pin, value) < 0) {
+    gpioErrors.add(1);
+    return errGpioWrite;
+  }
+  return Result<void>();
+}
+
+#ifndef OMEGA_GPIO_MMAP
+//The register backend has its own versions of these in gpio_mmap.cpp
+Result<unsigned int> readPins(unsigned int mask) {
+  TraceScope trace(traceReadPin);
+  unsigned int values = 0;
+  for(int pin = 0; pin < 32; pin++) {
+    if(!(mask & (1U << pin))) {
+      continue;
+    }
+    int value = gpio_get_value(pin);
+    if(value < 0) {
+      gpioErrors.add(1);
+      return errGpioRead;
+    }
+    if(value) {
+      values |= 1U << pin;
+    }
+  }
+  return values;
+}
+
+Result<void> writePins(unsigned int mask, unsigned int values) {
+  TraceScope trace(traceWritePin);
+  ErrorCode error = errNone;
+  for(int pin = 0; pin < 32; pin++) {
+    if(!(mask & (1U << pin))) {
+      continue;
+    }
+    int value = (values >> pin) & 1;
+    tracePin(pin, value);
+    //Keep going so the other pins still get set
+    if(gpio_set_value(pin, value) < 0) {
+      gpioErrors.add(1);
+      error = errGpioWrite;
+    }
+  }
+  return error;
+}
+#endif
+
+#if !defined(OMEGA_GPIO_SIM) && !defined(OMEGA_GPIO_MMAP)
+//The simulator and register backend have their own in gpio_sim.cpp and
+//gpio_mmap.cpp
+void forcePinsHigh(unsigned int mask) {
+  //Straight to the sysfs value files, the path built by hand since snprintf
+  //isn't safe in a signal handler
+  const char prefix[] = "/sys/class/gpio/gpio";
+  const char suffix[] = "/value";
+  for(int pin = 0; pin < 32; pin++) {
+    if(!(mask & (1U << pin))) {
+      continue;
+    }
+    char path[sizeof(prefix) + sizeof(suffix) + 2];
+    char *spot = path;
+    for(const char *c = prefix; *c; c++) {
+      *spot++ = *c;
+    }
+    if(pin >= 10) {
+      *spot++ = '0' + pin / 10;
+    }
+    *spot++ = '0' + pin % 10;
+    for(const char *c = suffix; *c; c++) {
+      *spot++ = *c;
+    }
+    *spot = '\0';
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if(fd >= 0) {
+      if(write(fd, "1", 1) < 0) {
+        //Nothing more can be done from here
+      }
+      close(fd);
+    }
+  }
+}
+#endif
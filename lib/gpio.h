@@ -0,0 +1,148 @@
+#ifndef GPIO_H
+#define GPIO_H
+
+#include "result.h"
+#include "metrics.h"
+#include "trace.h"
+#include "board.h"
+
+#if defined(OMEGA_GPIO_SIM) || defined(OMEGA_GPIO_MMAP)
+//Host builds use the simulator in gpio_sim.cpp, and OMEGA_GPIO_MMAP builds
+//the registers in gpio_mmap.cpp, behind the same calls as ugpio
+extern "C" {
+int gpio_is_requested(unsigned int gpio);
+int gpio_request(unsigned int gpio, const char *label);
+int gpio_free(unsigned int gpio);
+int gpio_direction_input(unsigned int gpio);
+int gpio_direction_output(unsigned int gpio, int value);
+int gpio_get_value(unsigned int gpio);
+int gpio_set_value(unsigned int gpio, int value);
+}
+#else
+#include <ugpio/ugpio.h> //For GPIO
+#endif
+
+#ifdef OMEGA_GPIO_SIM
+//Simulator hooks
+//Set the value an input pin will read
+void simSetInput(int pin, int value);
+//Get the last value written to an output pin
+int simGetOutput(int pin);
+//Monotonic time in nanoseconds the pin last changed value, -1 if it hasn't
+//changed since simClearChangeTimes
+long long simPinChangeTime(int pin);
+void simClearChangeTimes();
+//Load a sensor script. Each line is "<reads> <left> <front> <right>": the
+//sensor pins hold those values for that many sensor reads, then the next
+//line is used. Returns the number of steps or a negative number on error.
+//Also loaded on the first sensor read from the OMEGA_SIM_SCRIPT variable.
+//OMEGA_SIM_STALL=<read>:<millis> makes that sensor read (counted from 1)
+//take millis, to see what the watchdog does when the control thread stalls.
+int simLoadScript(const char *path);
+//Waits up to timeoutMillis for the simulated wheel encoders to change and
+//returns the encoder pins that did (see encoder.h). The pulses are made up
+//from how long each side's motor pins have been on, so they follow the
+//software PWM duty.
+unsigned int simWaitEdges(int timeoutMillis);
+//Fills levels with an analog line array frame of count elements made up
+//from the current script step: the left third of the bar shows the left
+//sensor, the right third the right one and the rest the front (see
+//linearray.h). Counts as one sensor read.
+void simLineFrame(unsigned char *levels, int count);
+#endif
+
+#ifdef OMEGA_GPIO_MMAP
+//The data, set (DSET) and clear (DCLR) registers once gpio_mmap.cpp has
+//mapped them, NULL before. Writes go through set and clear, so they never
+//read the data register and can't undo a store from another thread.
+extern volatile unsigned int *gpioData;
+extern volatile unsigned int *gpioSet;
+extern volatile unsigned int *gpioClear;
+//OMEGA_GPIO_MEM names a plain file, which doesn't act on DSET and DCLR, so
+//the data register has to be written as well
+extern bool gpioMemFile;
+//Maps the registers, returns false if they can't be
+bool gpioMap();
+#endif
+
+//Single reads and writes of a pin that has already been set up
+Result<int> readPin(int pin);
+Result<void> writePin(int pin, int value);
+
+/*
+readPin, writePin for board pins:
+  The same for a pin of Board (e.g. readPin<Board::SensorFront>()), checked
+  when compiling and built into a load of the data register or a store to
+  the set or clear register with the register backend, or a call with the
+  pin number fixed otherwise.
+*/
+template <typename P>
+  Result<int> readPin() {
+    static_assert(P::direction == pinInput, "only sensors (inputs) can be read");
+    TraceScope trace(traceReadPin);
+#ifdef OMEGA_GPIO_MMAP
+    if(__builtin_expect(!gpioData, 0) && !gpioMap()) {
+      gpioErrors.add(1);
+      return errGpioRead;
+    }
+    return (*gpioData & P::mask) ? 1 : 0;
+#else
+    int value = gpio_get_value(P::gpio);
+    if(value < 0) {
+      gpioErrors.add(1);
+      return errGpioRead;
+    }
+    return value;
+#endif
+  }
+template <typename P>
+  Result<void> writePin(int value) {
+    static_assert(P::direction == pinOutput, "only motors (outputs) can be written");
+    TraceScope trace(traceWritePin);
+    tracePin(P::gpio, value);
+#ifdef OMEGA_GPIO_MMAP
+    if(__builtin_expect(!gpioData, 0) && !gpioMap()) {
+      gpioErrors.add(1);
+      return errGpioWrite;
+    }
+    *(value ? gpioSet : gpioClear) = P::mask;
+    if(__builtin_expect(gpioMemFile, 0)) {
+      *gpioData = value ? *gpioData | P::mask : *gpioData & ~P::mask;
+    }
+#else
+    if(gpio_set_value(P::gpio, value) < 0) {
+      gpioErrors.add(1);
+      return errGpioWrite;
+    }
+#endif
+    return Result<void>();
+  }
+//Reads every pin in mask at once (pins 0-31), bit n of the value is pin n.
+//The register backend does this in one load, the others one pin at a time.
+Result<unsigned int> readPins(unsigned int mask);
+//Sets every pin in mask to the matching bit of values, in one store with
+//the register backend
+Result<void> writePins(unsigned int mask, unsigned int values);
+
+//Sets every pin in mask high (for the motors, off) with nothing but
+//async-signal-safe calls and no tracing or metrics, so the watchdog thread
+//and signal handlers can stop the car wherever the control thread is
+void forcePinsHigh(unsigned int mask);
+
+//GPIO values, from the board layout in board.h
+//IR Sensors
+//DIRECTION -> input
+const int sensorLeft = Board::SensorLeft::gpio;
+const int sensorRight = Board::SensorRight::gpio;
+const int sensorFront = Board::SensorFront::gpio;
+
+//Motors
+//DIRECTION -> output
+//Forward
+const int motorFL = Board::MotorFL::gpio;
+const int motorFR = Board::MotorFR::gpio;
+//Reverse
+const int motorRL = Board::MotorRL::gpio;
+const int motorRR = Board::MotorRR::gpio;
+
+#endif
@@ -0,0 +1,193 @@
+#include <cstdlib> //For getenv
+#include <fcntl.h> //For open
+#include <sys/mman.h> //For mmap
+#include <unistd.h> //For close
+#include "gpio.h"
+#include "metrics.h"
+#include "trace.h"
+
+/*
+Register backend
+-----------------
+Drives the pins straight through the MT7688 GPIO registers mapped from
+/dev/mem, so a read or write is a load or store instead of a system call.
+Only pins 0-31 (the first bank) are supported, and the pins have to be muxed
+as GPIOs already (omega2-ctrl gpiomux).
+
+OMEGA_GPIO_MEM and OMEGA_GPIO_BASE override the file and offset mapped, so a
+plain 4096 byte file can stand in for the registers on any Linux machine:
+  OMEGA_GPIO_MEM=regs.bin OMEGA_GPIO_BASE=0 ./carMaze
+*/
+
+//Page holding the GPIO block, and the registers in it
+const unsigned long gpioPage = 0x10000000;
+const int gpioMapSize = 4096;
+const int ctrlRegister = 0x600 / 4; //Direction, 1 is output
+const int dataRegister = 0x620 / 4; //Pin values
+const int setRegister = 0x630 / 4; //GPIO_DSET, writing 1 sets the pin high
+const int clearRegister = 0x640 / 4; //GPIO_DCLR, writing 1 sets the pin low
+const int bankPins = 32;
+
+static volatile unsigned int *registers = NULL;
+volatile unsigned int *gpioData = NULL;
+volatile unsigned int *gpioSet = NULL;
+volatile unsigned int *gpioClear = NULL;
+bool gpioMemFile = false;
+static bool requested[bankPins];
+
+/*
+mapRegisters:
+  Maps the register page the first time it is needed
+*/
+static bool mapRegisters() {
+  if(registers) {
+    return true;
+  }
+  const char *path = getenv("OMEGA_GPIO_MEM");
+  const char *base = getenv("OMEGA_GPIO_BASE");
+  unsigned long offset = base ? strtoul(base, NULL, 0) : gpioPage;
+  int fd = open(path ? path : "/dev/mem", O_RDWR | O_SYNC);
+  if(fd < 0) {
+    return false;
+  }
+  void *map = mmap(NULL, gpioMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, offset);
+  close(fd);
+  if(map == MAP_FAILED) {
+    return false;
+  }
+  registers = (volatile unsigned int *)map;
+  gpioData = registers + dataRegister;
+  gpioSet = registers + setRegister;
+  gpioClear = registers + clearRegister;
+  gpioMemFile = path != NULL;
+  return true;
+}
+
+/*
+storePins:
+  Sets the pins in high and clears the pins in low through DSET and DCLR, so
+  nothing is read first and a store from another thread or a signal handler
+  can't be undone. High goes first, so motors turn off before others turn
+  on. A plain file standing in for the registers doesn't act on DSET and
+  DCLR, so then the data register is changed too.
+*/
+static void storePins(unsigned int high, unsigned int low) {
+  if(high) {
+    registers[setRegister] = high;
+  }
+  if(low) {
+    registers[clearRegister] = low;
+  }
+  if(gpioMemFile) {
+    registers[dataRegister] = (registers[dataRegister] | high) & ~low;
+  }
+}
+
+bool gpioMap() {
+  return mapRegisters();
+}
+
+/*
+validPin:
+  Checks the pin is in the first bank and the registers are mapped
+*/
+static bool validPin(unsigned int gpio) {
+  return gpio < (unsigned int)bankPins && mapRegisters();
+}
+
+extern "C" {
+
+int gpio_is_requested(unsigned int gpio) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  return requested[gpio];
+}
+
+int gpio_request(unsigned int gpio, const char *label) {
+  (void)label;
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  requested[gpio] = true;
+  return 0;
+}
+
+int gpio_free(unsigned int gpio) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  requested[gpio] = false;
+  return 0;
+}
+
+int gpio_direction_input(unsigned int gpio) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  registers[ctrlRegister] &= ~(1U << gpio);
+  return 0;
+}
+
+int gpio_direction_output(unsigned int gpio, int value) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  //Set the value first so the pin doesn't glitch when it becomes an output
+  gpio_set_value(gpio, value);
+  registers[ctrlRegister] |= 1U << gpio;
+  return 0;
+}
+
+int gpio_get_value(unsigned int gpio) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  return (registers[dataRegister] >> gpio) & 1;
+}
+
+int gpio_set_value(unsigned int gpio, int value) {
+  if(!validPin(gpio)) {
+    return -1;
+  }
+  if(value) {
+    storePins(1U << gpio, 0);
+  }
+  else {
+    storePins(0, 1U << gpio);
+  }
+  return 0;
+}
+
+}
+
+Result<unsigned int> readPins(unsigned int mask) {
+  TraceScope trace(traceReadPin);
+  if(!mapRegisters()) {
+    gpioErrors.add(1);
+    return errGpioRead;
+  }
+  return registers[dataRegister] & mask;
+}
+
+Result<void> writePins(unsigned int mask, unsigned int values) {
+  TraceScope trace(traceWritePin);
+  if(!mapRegisters()) {
+    gpioErrors.add(1);
+    return errGpioWrite;
+  }
+  for(int pin = 0; pin < bankPins; pin++) {
+    if(mask & (1U << pin)) {
+      tracePin(pin, (values >> pin) & 1);
+    }
+  }
+  storePins(values & mask, ~values & mask);
+  return Result<void>();
+}
+
+void forcePinsHigh(unsigned int mask) {
+  //Not mapped means nothing was ever written, so nothing is driving
+  if(registers) {
+    storePins(mask, 0);
+  }
+}
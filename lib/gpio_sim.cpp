@@ -0,0 +1,267 @@
+#include <cstdio> //For reading sensor scripts
+#include <cstdlib> //For getenv
+#include <ctime> //For clock_gettime
+#include <atomic>
+#include "gpio.h"
+
+//Simulated GPIO state, one entry per pin. Directions and values are atomic
+//since the encoder thread reads the motors and writes the encoder pins.
+const int simPinCount = 32;
+static bool simRequested[simPinCount];
+static std::atomic<bool> simOutput[simPinCount];
+static std::atomic<int> simValue[simPinCount];
+//When each pin last changed, 0 if it hasn't
+static long long simChangeTime[simPinCount];
+
+//Sensor script, see simLoadScript
+struct SimStep {
+  long reads;
+  int left;
+  int front;
+  int right;
+};
+const int simMaxSteps = 1024;
+static SimStep simSteps[simMaxSteps];
+static int simStepCount = 0;
+static int simStepSpot = 0;
+static long simStepReads = 0;
+static bool simScriptChecked = false;
+//OMEGA_SIM_STALL=<read>:<millis> holds the control thread up for millis on
+//that sensor read, as if it were stuck, for trying the watchdog
+static long simReads = 0;
+static long simStallRead = -1;
+static long simStallMillis = 0;
+
+//Simulated wheel encoders: an edge for every simEdgeMicros a side's motor
+//is on, so a full speed 90 degree turn at the default turn time reads as
+//about 90 degrees (see encoder.h). Only touched by the encoder thread.
+const long simEdgeMicros = 90000;
+const long simEdgeSampleMicros = 1000;
+static long simWheelOn[2];
+
+/*
+simValid:
+  Checks that the pin exists on the simulated board
+*/
+static bool simValid(unsigned int gpio) {
+  return gpio < (unsigned int)simPinCount;
+}
+
+/*
+simApplyStep:
+  Puts the sensor values of the current script step on the sensor pins
+*/
+static void simApplyStep() {
+  simSetInput(sensorLeft, simSteps[simStepSpot].left);
+  simSetInput(sensorFront, simSteps[simStepSpot].front);
+  simSetInput(sensorRight, simSteps[simStepSpot].right);
+}
+
+/*
+simSensorRead:
+  Called on every read of a sensor pin. Loads the script named by
+  OMEGA_SIM_SCRIPT the first time and moves to the next step once the
+  current one has been read enough times. The last step is held forever.
+*/
+static void simSensorRead() {
+  if(!simScriptChecked) {
+    simScriptChecked = true;
+    const char *path = getenv("OMEGA_SIM_SCRIPT");
+    if(path && simLoadScript(path) < 0) {
+      fprintf(stderr, "Could not load simulator script %s\n", path);
+    }
+    const char *stall = getenv("OMEGA_SIM_STALL");
+    if(stall && sscanf(stall, "%ld:%ld", &simStallRead, &simStallMillis) != 2) {
+      fprintf(stderr, "Could not read OMEGA_SIM_STALL %s\n", stall);
+      simStallRead = -1;
+    }
+  }
+  if(++simReads == simStallRead) {
+    timespec pause = { simStallMillis / 1000, simStallMillis % 1000 * 1000000 };
+    nanosleep(&pause, NULL);
+  }
+  if(!simStepCount) {
+    return;
+  }
+  if(simStepReads >= simSteps[simStepSpot].reads && simStepSpot < simStepCount - 1) {
+    simStepSpot ++;
+    simStepReads = 0;
+    simApplyStep();
+  }
+  simStepReads ++;
+}
+
+extern "C" {
+
+int gpio_is_requested(unsigned int gpio) {
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  return simRequested[gpio];
+}
+
+int gpio_request(unsigned int gpio, const char *label) {
+  (void)label;
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  simRequested[gpio] = true;
+  return 0;
+}
+
+int gpio_free(unsigned int gpio) {
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  simRequested[gpio] = false;
+  return 0;
+}
+
+int gpio_direction_input(unsigned int gpio) {
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  simOutput[gpio] = false;
+  return 0;
+}
+
+int gpio_direction_output(unsigned int gpio, int value) {
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  simOutput[gpio] = true;
+  simValue[gpio] = value;
+  return 0;
+}
+
+int gpio_get_value(unsigned int gpio) {
+  if(!simValid(gpio)) {
+    return -1;
+  }
+  if((int)gpio == sensorLeft || (int)gpio == sensorFront || (int)gpio == sensorRight) {
+    simSensorRead();
+  }
+  return simValue[gpio];
+}
+
+int gpio_set_value(unsigned int gpio, int value) {
+  if(!simValid(gpio) || !simOutput[gpio]) {
+    return -1;
+  }
+  value = value ? 1 : 0;
+  if(simValue[gpio] != value) {
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    simChangeTime[gpio] = now.tv_sec * 1000000000LL + now.tv_nsec;
+  }
+  simValue[gpio] = value;
+  return 0;
+}
+
+}
+
+void simSetInput(int pin, int value) {
+  if(simValid(pin) && !simOutput[pin]) {
+    simValue[pin] = value ? 1 : 0;
+  }
+}
+
+int simGetOutput(int pin) {
+  if(!simValid(pin)) {
+    return -1;
+  }
+  return simValue[pin];
+}
+
+long long simPinChangeTime(int pin) {
+  if(!simValid(pin) || !simChangeTime[pin]) {
+    return -1;
+  }
+  return simChangeTime[pin];
+}
+
+void simClearChangeTimes() {
+  for(int i = 0; i < simPinCount; i++) {
+    simChangeTime[i] = 0;
+  }
+}
+
+int simLoadScript(const char *path) {
+  FILE *in = fopen(path, "r");
+  if(!in) {
+    return -1;
+  }
+  char line[128];
+  simStepCount = 0;
+  while(simStepCount < simMaxSteps && fgets(line, sizeof(line), in)) {
+    SimStep step;
+    if(line[0] == '#') {
+      continue;
+    }
+    if(sscanf(line, "%ld %d %d %d", &step.reads, &step.left, &step.front, &step.right) == 4) {
+      simSteps[simStepCount] = step;
+      simStepCount ++;
+    }
+  }
+  fclose(in);
+  simScriptChecked = true;
+  simStepSpot = 0;
+  simStepReads = 0;
+  if(!simStepCount) {
+    return -2;
+  }
+  simApplyStep();
+  return simStepCount;
+}
+
+void forcePinsHigh(unsigned int mask) {
+  for(int pin = 0; pin < simPinCount; pin++) {
+    if((mask & (1U << pin)) && simOutput[pin]) {
+      simValue[pin] = 1;
+    }
+  }
+}
+
+/*
+simMotorOn:
+  Whether a motor pin is set up and driving (low)
+*/
+static bool simMotorOn(int pin) {
+  return simOutput[pin] && !simValue[pin];
+}
+
+unsigned int simWaitEdges(int timeoutMillis) {
+  const int encoders[2] = { Board::EncoderLeft::gpio, Board::EncoderRight::gpio };
+  for(long waited = 0; waited < timeoutMillis * 1000L; waited += simEdgeSampleMicros) {
+    timespec pause = { 0, simEdgeSampleMicros * 1000 };
+    nanosleep(&pause, NULL);
+    //Each side's wheel turns while its forward or reverse pin is on
+    bool on[2] = { simMotorOn(motorFL) || simMotorOn(motorRL), simMotorOn(motorFR) || simMotorOn(motorRR) };
+    unsigned int changed = 0;
+    for(int i = 0; i < 2; i++) {
+      if(!on[i]) {
+        continue;
+      }
+      simWheelOn[i] += simEdgeSampleMicros;
+      if(simWheelOn[i] >= simEdgeMicros) {
+        simWheelOn[i] -= simEdgeMicros;
+        simValue[encoders[i]] = !simValue[encoders[i]];
+        changed |= 1U << encoders[i];
+      }
+    }
+    if(changed) {
+      return changed;
+    }
+  }
+  return 0;
+}
+
+void simLineFrame(unsigned char *levels, int count) {
+  simSensorRead();
+  int third = count / 3;
+  for(int i = 0; i < count; i++) {
+    int line = i < third ? simValue[sensorLeft] : i >= count - third ? simValue[sensorRight] : simValue[sensorFront];
+    //Spread over the range like real reflectance readings
+    levels[i] = line ? 100 + i * 37 % 28 : i * 53 % 40;
+  }
+}
@@ -0,0 +1,111 @@
+#include "junction.h"
+#include "sensors.h"
+
+const unsigned int allPathBits = irFrontPath | irLeftPath | irRightPath;
+const unsigned int corridorPaths = irFrontPath;
+
+void junctionReset(JunctionHistory &history, unsigned long micros, unsigned int paths) {
+  history.newest = 0;
+  history.count = 1;
+  history.samples[0].micros = micros;
+  history.samples[0].paths = paths;
+  history.samples[0].reads = 1;
+}
+
+void junctionRecord(JunctionHistory &history, unsigned long micros, unsigned int bit, bool path) {
+  JunctionSample &newest = history.samples[history.newest];
+  unsigned int paths = path ? newest.paths | bit : newest.paths & ~bit;
+  if(paths == newest.paths) {
+    newest.reads ++;
+    return;
+  }
+  //Overwrite the oldest once full
+  history.newest = (history.newest + 1) % junctionSamples;
+  if(history.count < junctionSamples) {
+    history.count ++;
+  }
+  JunctionSample &added = history.samples[history.newest];
+  added.micros = micros;
+  added.paths = paths;
+  added.reads = 1;
+}
+
+//Samples a sensor at a time can take to go from the pad to the front lost
+const int padExitSamples = 3;
+
+bool junctionFinished(const JunctionHistory &history, unsigned long now) {
+  const JunctionSample &newest = history.samples[history.newest];
+  if(newest.paths == allPathBits) {
+    return now - newest.micros >= junctionFinishMicros;
+  }
+  if(!(newest.paths & irFrontPath)) {
+    return false;
+  }
+  //Just came off the far side of the finish pad
+  unsigned long end = newest.micros;
+  for(int back = 1; back <= padExitSamples && back < history.count; back++) {
+    const JunctionSample &sample = history.samples[(history.newest + junctionSamples - back) % junctionSamples];
+    if(!sample.paths) {
+      return end - sample.micros >= junctionFinishMicros;
+    }
+    end = sample.micros;
+  }
+  return false;
+}
+
+JunctionType classifyJunction(const JunctionHistory &history, unsigned long now) {
+  //Walk back to the last real corridor, then look at what came after it
+  int oldest = history.count;
+  for(int back = 0; back < history.count; back++) {
+    const JunctionSample &sample = history.samples[(history.newest + junctionSamples - back) % junctionSamples];
+    if(sample.paths == corridorPaths && sample.reads >= junctionDebounceReads) {
+      oldest = back;
+      break;
+    }
+  }
+  unsigned int leftReads = 0, rightReads = 0;
+  unsigned long end = now;
+  //Whether the front lost its line after the sample being looked at
+  bool frontLost = false;
+  for(int back = 0; back < oldest; back++) {
+    const JunctionSample &sample = history.samples[(history.newest + junctionSamples - back) % junctionSamples];
+    bool pad = !sample.paths && frontLost;
+    if((pad || sample.paths == allPathBits) && end - sample.micros >= junctionFinishMicros) {
+      return junctionFinish;
+    }
+    if(sample.paths & irFrontPath) {
+      frontLost = true;
+    }
+    if(sample.paths & irLeftPath) {
+      leftReads += sample.reads;
+    }
+    if(sample.paths & irRightPath) {
+      rightReads += sample.reads;
+    }
+    end = sample.micros;
+  }
+  //What the sensors see now is trusted as it is, earlier openings need to
+  //have lasted
+  unsigned int current = history.samples[history.newest].paths;
+  bool left = (current & irLeftPath) || leftReads >= (unsigned int)junctionDebounceReads;
+  bool right = (current & irRightPath) || rightReads >= (unsigned int)junctionDebounceReads;
+  bool front = current & irFrontPath;
+  if(left && right) {
+    return front ? junctionCross : junctionT;
+  }
+  if(left) {
+    return junctionLeft;
+  }
+  if(right) {
+    return junctionRight;
+  }
+  return front ? junctionNone : junctionDeadEnd;
+}
+
+const char *junctionName(JunctionType type) {
+  const char *names[] = { "none", "L", "R", "T", "+", "dead end", "finish" };
+  if(type < junctionNone || type > junctionFinish) {
+    return "unknown";
+  }
+  return names[type];
+}
@@ -0,0 +1,61 @@
+#ifndef JUNCTION_H
+#define JUNCTION_H
+
+/*
+Junction classification
+------------------------
+moveForward records every sensor reading into a history of how long each
+combination of paths (irFrontPath, irLeftPath and irRightPath bits, see
+sensors.h) was seen for. classifyJunction looks back at the readings since
+the car was last in a plain corridor (walls on both sides, path ahead) and
+types the junction from how long each side stayed open, whether the front
+was lost, and how long every sensor saw a line (or none did).
+
+The finish is either no sensor seeing a line for junctionFinishMicros (off
+the end onto bare floor), or every sensor on a line that long and then the
+front losing it (driven across the finish pad and off its far side). A
+solid bar on its own is not the finish: moveForward keeps driving while the
+front sees a line, so a bar held long enough would otherwise end every run
+at the first wide line.
+
+The history only gets a new entry when the combination changes and holds a
+fixed number of them, so recording and classifying take bounded time.
+*/
+
+enum JunctionType {
+  junctionNone, //Still a corridor, or openings too short to be real
+  junctionLeft, //Path on the left, not the right
+  junctionRight, //Path on the right, not the left
+  junctionT, //Paths both sides, none ahead
+  junctionCross, //Paths both sides and ahead
+  junctionDeadEnd, //No paths
+  junctionFinish //No lines for too long, or a long pad of lines then none ahead
+};
+
+//Readings of a combination before an opening counts, so one bad read
+//doesn't make a junction (moveForward also waits for two)
+const int junctionDebounceReads = 2;
+//Time off all lines, or on the finish pad, that means the end
+const unsigned long junctionFinishMicros = 300000;
+
+struct JunctionSample {
+  unsigned long micros; //When this combination was first read
+  unsigned int paths;
+  unsigned int reads;
+};
+const int junctionSamples = 64;
+struct JunctionHistory {
+  JunctionSample samples[junctionSamples];
+  int newest;
+  int count;
+};
+
+void junctionReset(JunctionHistory &history, unsigned long micros, unsigned int paths);
+//Records one sensor reading, bit is that sensor's ir*Path bit
+void junctionRecord(JunctionHistory &history, unsigned long micros, unsigned int bit, bool path);
+//Cheap check for the end of the maze, fine to call every loop
+bool junctionFinished(const JunctionHistory &history, unsigned long now);
+JunctionType classifyJunction(const JunctionHistory &history, unsigned long now);
+const char *junctionName(JunctionType type);
+
+#endif
@@ -0,0 +1,276 @@
+#include <cstdlib> //For strtol
+#include <cstring> //For strncmp
+#include <fcntl.h> //For open
+#include <termios.h> //For the serial link
+#include <unistd.h> //For read and close
+#ifdef __SSE2__
+#include <emmintrin.h> //For SSE2
+#endif
+#include "linearray.h"
+#include "gpio.h"
+#include "sensors.h"
+#include "tuning.h"
+
+enum LineSource {
+  lineSourceNone,
+  lineSourceGpio,
+  lineSourceAnalog
+};
+static LineSource source = lineSourceNone;
+static int elements = 0;
+//Elements' pins, and whether lineArrayConfigure requested them
+static int gpios[lineMaxSensors];
+static bool gpioClaimed[lineMaxSensors];
+static unsigned int gpioMask = 0;
+//Serial link to the dock, the frame being read (-1 before a sync byte) and
+//the newest whole frame
+static int device = -1;
+static int frameFill = -1;
+static bool haveFrame = false;
+#ifndef OMEGA_GPIO_SIM
+static unsigned char frame[lineMaxSensors];
+static unsigned char lastFrame[lineMaxSensors];
+#endif
+//Elements standing in for each IR direction
+static unsigned int regionMask[3];
+
+/*
+setRegions:
+  Splits the bar into thirds for the IR directions, the middle one taking
+  what doesn't divide evenly
+*/
+static void setRegions(int count) {
+  unsigned int all = (1U << count) - 1;
+  int third = count / 3;
+  regionMask[1] = (1U << third) - 1;
+  regionMask[2] = regionMask[1] << (count - third);
+  regionMask[0] = all & ~regionMask[1] & ~regionMask[2];
+}
+
+#ifndef OMEGA_GPIO_SIM
+/*
+openLink:
+  Opens the dock's serial link raw at 115200 baud, without blocking so a
+  sample only takes what has already arrived
+*/
+static int openLink(const char *path) {
+  int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+  if(fd < 0) {
+    return -1;
+  }
+  termios settings;
+  if(tcgetattr(fd, &settings) == 0) {
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, B115200);
+    tcsetattr(fd, TCSANOW, &settings);
+  }
+  return fd;
+}
+#endif
+
+Result<void> lineArrayConfigure(const char *spec) {
+  lineArrayClose();
+  char *end;
+  int count = 0;
+  if(!strncmp(spec, "analog:", 7)) {
+    count = strtol(spec + 7, &end, 10);
+    if(count < lineMinSensors || count > lineMaxSensors) {
+      return errBadParameter;
+    }
+#ifndef OMEGA_GPIO_SIM
+    //The simulator makes the frames up, so it doesn't need a device
+    if(*end != ':') {
+      return errBadParameter;
+    }
+    if((device = openLink(end + 1)) < 0) {
+      return errFileRead;
+    }
+#endif
+    source = lineSourceAnalog;
+  }
+  else if(!strncmp(spec, "gpio:", 5)) {
+    const char *spot = spec + 5;
+    while(*spot && count < lineMaxSensors) {
+      int pin = strtol(spot, &end, 10);
+      if(end == spot || pin < 0 || pin > 31 || gpioMask & (1U << pin)) {
+        lineArrayClose();
+        return errBadParameter;
+      }
+      //Taking a motor or encoder pin would turn it into an input
+      if(boardPinMask & (1U << pin)) {
+        lineArrayClose();
+        return errPinInUse;
+      }
+      int requested = gpio_is_requested(pin);
+      if(requested < 0) {
+        lineArrayClose();
+        return errGpioRequested;
+      }
+      if(!requested && gpio_request(pin, NULL) < 0) {
+        lineArrayClose();
+        return errGpioRequest;
+      }
+      gpios[count] = pin;
+      gpioClaimed[count] = !requested;
+      gpioMask |= 1U << pin;
+      elements = ++count;
+      if(gpio_direction_input(pin) < 0) {
+        lineArrayClose();
+        return errGpioDirection;
+      }
+      spot = *end == ',' ? end + 1 : end;
+    }
+    if(count < lineMinSensors || *spot) {
+      lineArrayClose();
+      return errBadParameter;
+    }
+    source = lineSourceGpio;
+  }
+  else {
+    return errBadParameter;
+  }
+  elements = count;
+  setRegions(count);
+  return Result<void>();
+}
+
+void lineArrayClose() {
+  for(int i = 0; i < elements; i++) {
+    if(gpioClaimed[i]) {
+      gpio_free(gpios[i]);
+    }
+    gpioClaimed[i] = false;
+  }
+  if(device >= 0) {
+    close(device);
+    device = -1;
+  }
+  source = lineSourceNone;
+  elements = 0;
+  gpioMask = 0;
+  frameFill = -1;
+  haveFrame = false;
+}
+
+bool lineArrayOn() {
+  return source != lineSourceNone;
+}
+
+#ifndef OMEGA_GPIO_SIM
+/*
+readFrames:
+  Takes in everything the dock has sent since the last sample, keeping the
+  newest whole frame. Returns false if there has never been one.
+*/
+static bool readFrames() {
+  unsigned char bytes[64];
+  ssize_t got;
+  while((got = read(device, bytes, sizeof(bytes))) > 0) {
+    for(int i = 0; i < got; i++) {
+      if(bytes[i] > lineLevelMax) {
+        frameFill = 0;
+      }
+      else if(frameFill >= 0) {
+        frame[frameFill++] = bytes[i];
+        if(frameFill == elements) {
+          memcpy(lastFrame, frame, elements);
+          haveFrame = true;
+          frameFill = -1;
+        }
+      }
+    }
+  }
+  return haveFrame;
+}
+#endif
+
+Result<void> sampleLine(LineSample &sample) {
+  sample.count = elements;
+  memset(sample.levels, 0, sizeof(sample.levels));
+  if(source == lineSourceGpio) {
+    Result<unsigned int> reading = retry(tuning().gpioRetry, []() { return readPins(gpioMask); });
+    if(!reading.ok()) {
+      return reading.getError();
+    }
+    for(int i = 0; i < elements; i++) {
+      sample.levels[i] = reading.get() & (1U << gpios[i]) ? lineLevelMax : 0;
+    }
+    return Result<void>();
+  }
+  if(source == lineSourceAnalog) {
+#ifdef OMEGA_GPIO_SIM
+    simLineFrame(sample.levels, elements);
+#else
+    Result<void> reading = retry(tuning().gpioRetry, []() { return readFrames() ? Result<void>() : Result<void>(errSensorRead); });
+    if(!reading.ok()) {
+      return reading;
+    }
+    memcpy(sample.levels, lastFrame, elements);
+#endif
+    return Result<void>();
+  }
+  return errBadParameter;
+}
+
+/*
+finishShape:
+  Fills in shape from the mask of elements seeing the line and the level
+  sums both paths of lineShape work out
+*/
+static void finishShape(unsigned int mask, unsigned long total, unsigned long weighted, LineShape &shape) {
+  shape.lineMask = mask;
+  shape.width = __builtin_popcount(mask);
+  shape.centroid = total ? (int)(weighted * 256 / total) : -1;
+  shape.paths = 0;
+  for(int direction = 0; direction < 3; direction++) {
+    if(!(mask & regionMask[direction])) {
+      shape.paths |= 1U << direction;
+    }
+  }
+}
+
+void lineShapeWords(const LineSample &sample, LineShape &shape) {
+  const unsigned int high = 0x80808080U;
+  const unsigned int over = (lineThreshold + 1) * 0x01010101U;
+  unsigned int mask = 0;
+  unsigned long lanes = 0, weighted = 0;
+  for(int word = 0; word < lineMaxSensors / 4; word++) {
+    const unsigned char *four = sample.levels + word * 4;
+    unsigned int levels = four[0] | four[1] << 8 | four[2] << 16 | (unsigned int)four[3] << 24;
+    //High bit of each byte set when its level is over the threshold. With
+    //levels at most 127 no borrow crosses into the next byte.
+    unsigned int above = ((levels | high) - over) & high;
+    //Gathers the four high bits into bits 21-24
+    mask |= ((above >> 7) * 0x00204081U >> 21 & 0xF) << word * 4;
+    unsigned int line = levels & (above >> 7) * 0xFF;
+    //Elements 0 and 2 and elements 1 and 3 of the word in 16 bit lanes
+    unsigned int even = line & 0x00FF00FF;
+    unsigned int odd = (line >> 8) & 0x00FF00FF;
+    unsigned int pairs = even + odd;
+    lanes += pairs;
+    weighted += word * 4 * ((pairs & 0xFFFF) + (pairs >> 16)) + (odd & 0xFFFF) + 2 * (even >> 16) + 3 * (odd >> 16);
+  }
+  finishShape(mask, (lanes & 0xFFFF) + (lanes >> 16), weighted, shape);
+}
+
+void lineShape(const LineSample &sample, LineShape &shape) {
+#ifdef __SSE2__
+  __m128i levels = _mm_load_si128((const __m128i *)sample.levels);
+  //Levels are at most 127, so the signed compare works
+  __m128i above = _mm_cmpgt_epi8(levels, _mm_set1_epi8(lineThreshold));
+  unsigned int mask = _mm_movemask_epi8(above);
+  __m128i line = _mm_and_si128(levels, above);
+  __m128i zero = _mm_setzero_si128();
+  //Sum of level times element number, 16 bit products added in pairs
+  __m128i sums = _mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi8(line, zero), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7)),
+    _mm_madd_epi16(_mm_unpackhi_epi8(line, zero), _mm_setr_epi16(8, 9, 10, 11, 12, 13, 14, 15)));
+  sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0x4E));
+  sums = _mm_add_epi32(sums, _mm_shuffle_epi32(sums, 0xB1));
+  unsigned long weighted = _mm_cvtsi128_si32(sums);
+  __m128i totals = _mm_sad_epu8(line, zero);
+  unsigned long total = _mm_cvtsi128_si32(totals) + _mm_cvtsi128_si32(_mm_srli_si128(totals, 8));
+  finishShape(mask, total, weighted, shape);
+#else
+  lineShapeWords(sample, shape);
+#endif
+}
@@ -0,0 +1,63 @@
+#ifndef LINEARRAY_H
+#define LINEARRAY_H
+
+#include "result.h"
+
+/*
+Line array
+-----------
+A bar of 5-16 reflectance sensors across the front of the car, numbered
+left to right, instead of the three IR sensors. Each element reads a level
+from 0 (floor) to lineLevelMax (line). They come either from GPIOs (one
+digital element a pin, all read in one readPins) or over the Arduino dock's
+serial link as analog frames: a byte of 0x80 or more to sync, then one level
+byte per element. The simulator makes the frames up from its sensor script.
+
+lineShape works the whole bar out in one pass with 16 levels in one SSE2
+register, or 4 at a time in 32 bit words on the MIPS core: which elements
+see the line, how many, where its middle is, and the paths. The left third
+of the bar stands in for the left sensor, the right third for the right one
+and the middle for the front, so a direction has a path when none of its
+elements see a line. checkIR and checkAllIR use the bar when it is set up,
+so nothing above them changes.
+
+Set up with OMEGA_LINE_ARRAY (see lineArrayConfigure):
+  analog:<elements>:<serial device>   e.g. analog:8:/dev/ttyS1
+  gpio:<pin>,<pin>,...                 left to right, pins the board
+                                       doesn't use
+*/
+
+const int lineMaxSensors = 16;
+const int lineMinSensors = 5;
+const int lineLevelMax = 127;
+//Levels above this see the line
+const int lineThreshold = 64;
+
+struct LineSample {
+  alignas(16) unsigned char levels[lineMaxSensors]; //Past count are 0
+  int count;
+};
+
+struct LineShape {
+  unsigned int lineMask; //Bit n set when element n sees the line
+  int width; //Elements seeing the line
+  int centroid; //Middle of the line in 1/256 elements, -1 if there is none
+  unsigned int paths; //irFrontPath, irLeftPath and irRightPath bits
+};
+
+//Sets the bar up from a spec as above. Fails with errBadParameter if the
+//spec is bad, errFileRead if the device can't be opened, a GPIO error if a
+//pin can't be set up, or errPinInUse if it names a pin the board already
+//uses for a motor, sensor or encoder (boardPinMask in board.h).
+Result<void> lineArrayConfigure(const char *spec);
+void lineArrayClose();
+//Whether checkIR and checkAllIR read the bar
+bool lineArrayOn();
+//Reads the whole bar. Retried according to the gpioRetry tuning.
+Result<void> sampleLine(LineSample &sample);
+void lineShape(const LineSample &sample, LineShape &shape);
+//lineShape's 32 bit word path, what it runs without SSE2. Always built so
+//the host can check it against the SSE2 one.
+void lineShapeWords(const LineSample &sample, LineShape &shape);
+
+#endif
@@ -0,0 +1,460 @@
+#include <iostream> //For errors and warnings
+#include <ctime> //For logging time
+#include <cstring> //For building messages without allocating
+#include <cstdio> //For rename and the segment names
+#include <cstdlib> //For atexit
+#include <atomic>
+#include <dirent.h> //For finding old segments
+#include <fcntl.h> //For open
+#include <pthread.h> //For the rotator thread
+#include <sys/stat.h> //For file sizes
+#include <unistd.h> //For write and close
+#include "logging.h"
+#include "metrics.h"
+#include "trace.h"
+#include "lz4frame.h"
+#include "startup.h"
+
+using namespace std;
+
+const char *fileName = "log.txt";
+//Preallocated buffer for warning and error messages so nothing is allocated
+//while the car is running
+const int msgBufferSize = 256;
+static char msgBuffer[msgBufferSize];
+//Entries logged before startLog are kept here so opening the file does not
+//hold up the car starting. After that each entry is built here and written
+//straight out.
+const int pendingLogSize = 16384;
+static char pendingLog[pendingLogSize];
+static int pendingLength = 0;
+static bool logStarted = false;
+static bool exitHooked = false;
+//The file the control thread writes to, opened by startLog
+static int logFd = -1;
+
+//Rotation: the rotator thread moves the file to <fileName>.<n> once it is
+//this big or old, compresses it to <fileName>.<n>.lz4 and deletes the oldest
+//segments to keep everything under logDiskCap
+const long logRotateBytes = 256 * 1024;
+const long logRotateSeconds = 600;
+const long logDiskCap = 2 * 1024 * 1024;
+const int logMaxSegments = 64;
+//How long the rotator sleeps when there is nothing to do
+const int rotatorPollMicros = 20000;
+//The new file the rotator opened, until the control thread switches to it
+static std::atomic<int> freshFd(-1);
+static std::atomic<bool> stopRotator;
+static pthread_t rotatorThread;
+static bool rotatorRunning = false;
+
+/*
+appendText:
+  Copies text into [first, last) and returns the new end. Anything past last
+  is cut off.
+*/
+char *appendText(char *first, char *last, const char *text) {
+  size_t length = strlen(text);
+  if(length > (size_t)(last - first)) {
+    length = last - first;
+  }
+  memcpy(first, text, length);
+  return first + length;
+}
+
+/*
+formatMsg:
+  Builds "<label> <code> (<errorText>) occurred in function
+  <inFunction><extra>" in msgBuffer. Anything past the end of the buffer is
+  cut off.
+*/
+const char *formatMsg(const char *label, ErrorCode error, const char *inFunction, const char *extra) {
+  char *spot = msgBuffer;
+  char *last = msgBuffer + msgBufferSize - 1;
+  const char *parts[] = { label, " ", 0, " (", errorText(error), ") occurred in function ", inFunction, extra };
+  for(int i = 0; i < 8; i++) {
+    if(!parts[i]) {
+      spot = numberToChars(spot, last, (int)error);
+      continue;
+    }
+    spot = appendText(spot, last, parts[i]);
+  }
+  *spot = '\0';
+  return msgBuffer;
+}
+/*
+warnMsg function:
+  This function cout's the warning message and then calls the writeToLog function
+  to write the warning message in the log file
+*/
+void warnMsg(ErrorCode warning, const char *inFunction, const char *extra) {
+  writeToLog("warnMsg", 0, "");
+  const char *toOut = formatMsg("Warning", warning, inFunction, extra);
+  cerr << toOut << endl;
+  writeToLog(toOut, 2, extra);
+  writeToLog("warnMsg", 1, "");
+}
+/*
+errMsg function:
+  Similar to the warnMsg function, except for error messages
+*/
+void errMsg(ErrorCode error, const char *inFunction, const char *extra) {
+  writeToLog("errMsg", 0, "");
+  const char *toOut = formatMsg("Error", error, inFunction, extra);
+  cerr << toOut << endl;
+  writeToLog(toOut, 3, extra);
+  writeToLog("errMsg", 1, "");
+}
+//Rotator thread state
+struct LogSegment {
+  int number;
+  long bytes;
+};
+//Compressed segments on disk, oldest first
+static LogSegment segments[logMaxSegments];
+static int segmentCount = 0;
+static int nextSegment = 1;
+//Segments an earlier run left uncompressed
+const int maxLeftovers = 8;
+static int leftovers[maxLeftovers];
+static int leftoverCount = 0;
+static time_t logOpened = 0;
+//The segment being compressed, -1 when none
+static int compressing = -1;
+static int compressIn = -1, compressOut = -1;
+static long compressedBytes = 0;
+static unsigned char compressBuffer[lz4BlockSize];
+static unsigned char compressedBlock[lz4BoundSize + 4];
+
+/*
+segmentName:
+  <fileName>.<number>, with .lz4 after it when compressed
+*/
+static void segmentName(char *name, int size, int number, bool compressed) {
+  snprintf(name, size, "%s.%d%s", fileName, number, compressed ? ".lz4" : "");
+}
+
+/*
+logFileBytes:
+  Size of the log file, 0 if there isn't one
+*/
+static long logFileBytes() {
+  struct stat info;
+  return stat(fileName, &info) == 0 ? info.st_size : 0;
+}
+
+/*
+findSegments:
+  Picks up the segments earlier runs left, so they count toward the cap, any
+  left uncompressed get compressed and new ones get the next numbers
+*/
+static void findSegments() {
+  const char *slash = strrchr(fileName, '/');
+  char directory[256];
+  snprintf(directory, sizeof(directory), "%.*s", slash ? (int)(slash - fileName) : 1, slash ? fileName : ".");
+  const char *base = slash ? slash + 1 : fileName;
+  size_t baseLength = strlen(base);
+  DIR *listing = opendir(directory);
+  if(!listing) {
+    return;
+  }
+  dirent *entry;
+  while((entry = readdir(listing))) {
+    char *end;
+    if(strncmp(entry->d_name, base, baseLength) || entry->d_name[baseLength] != '.') {
+      continue;
+    }
+    long number = strtol(entry->d_name + baseLength + 1, &end, 10);
+    if(number <= 0 || number > 1000000000) {
+      continue;
+    }
+    if(number >= nextSegment) {
+      nextSegment = number + 1;
+    }
+    if(!*end) {
+      if(leftoverCount < maxLeftovers) {
+        leftovers[leftoverCount++] = number;
+      }
+      continue;
+    }
+    char name[300];
+    segmentName(name, sizeof(name), number, true);
+    struct stat info;
+    if(strcmp(end, ".lz4") || segmentCount == logMaxSegments || stat(name, &info) < 0) {
+      continue;
+    }
+    //Keep them in order, there are only a few
+    int spot = segmentCount++;
+    while(spot > 0 && segments[spot - 1].number > number) {
+      segments[spot] = segments[spot - 1];
+      spot --;
+    }
+    segments[spot].number = number;
+    segments[spot].bytes = info.st_size;
+  }
+  closedir(listing);
+}
+
+/*
+dropSegment:
+  Deletes the compressed segment at index from the disk and the list
+*/
+static void dropSegment(int index) {
+  char name[300];
+  segmentName(name, sizeof(name), segments[index].number, true);
+  unlink(name);
+  segmentCount --;
+  memmove(segments + index, segments + index + 1, (segmentCount - index) * sizeof(LogSegment));
+}
+
+/*
+capSegments:
+  Deletes the oldest segments until everything fits in logDiskCap
+*/
+static void capSegments() {
+  long total = logFileBytes();
+  for(int i = 0; i < segmentCount; i++) {
+    total += segments[i].bytes;
+  }
+  while(segmentCount && total > logDiskCap) {
+    total -= segments[0].bytes;
+    dropSegment(0);
+  }
+}
+
+/*
+startCompressing:
+  Opens segment number and its .lz4 (replacing any half written one) and
+  writes the frame header. compressStep does the rest.
+*/
+static void startCompressing(int number) {
+  char name[300];
+  segmentName(name, sizeof(name), number, false);
+  compressIn = open(name, O_RDONLY | O_CLOEXEC);
+  segmentName(name, sizeof(name), number, true);
+  compressOut = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if(compressIn < 0 || compressOut < 0) {
+    if(compressIn >= 0) {
+      close(compressIn);
+    }
+    if(compressOut >= 0) {
+      close(compressOut);
+    }
+    compressIn = compressOut = -1;
+    return;
+  }
+  compressing = number;
+  compressedBytes = write(compressOut, compressedBlock, lz4FrameHeader(compressedBlock));
+}
+
+/*
+compressStep:
+  Compresses the next block of the segment being compressed. At the end the
+  uncompressed segment is deleted and the cap is applied.
+*/
+static void compressStep() {
+  ssize_t length = read(compressIn, compressBuffer, lz4BlockSize);
+  if(length > 0) {
+    int size = lz4FrameBlock(compressBuffer, length, compressedBlock);
+    if(write(compressOut, compressedBlock, size) == size) {
+      compressedBytes += size;
+      return;
+    }
+    length = -1;
+  }
+  compressedBytes += write(compressOut, compressedBlock, lz4FrameEnd(compressedBlock));
+  close(compressIn);
+  close(compressOut);
+  compressIn = compressOut = -1;
+  char name[300];
+  segmentName(name, sizeof(name), compressing, length < 0);
+  //If it failed, keep the uncompressed segment for the next run to retry
+  unlink(name);
+  if(length == 0) {
+    if(segmentCount == logMaxSegments) {
+      dropSegment(0);
+    }
+    segments[segmentCount].number = compressing;
+    segments[segmentCount].bytes = compressedBytes;
+    segmentCount ++;
+  }
+  compressing = -1;
+  capSegments();
+}
+
+/*
+rotate:
+  Moves the log file aside as the next segment, opens a new one and hands it
+  to the control thread, which switches to it at its next entry. Until then
+  it is still writing to the segment, so compressing waits for that.
+*/
+static void rotate() {
+  char name[300];
+  segmentName(name, sizeof(name), nextSegment, false);
+  if(rename(fileName, name) < 0) {
+    return;
+  }
+  int fresh = open(fileName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if(fresh < 0) {
+    //Put it back, the control thread is still writing to it
+    rename(name, fileName);
+    return;
+  }
+  logOpened = time(0);
+  freshFd.store(fresh, std::memory_order_release);
+  startCompressing(nextSegment);
+  nextSegment ++;
+}
+
+/*
+rotateLogs:
+  Rotator thread. Rotates the log file when it gets too big or old and
+  compresses the old one a block at a time, so the control thread only ever
+  writes entries. Once stopLog asks it finishes the segment it is on, if the
+  control thread has let go of it.
+*/
+static void *rotateLogs(void *) {
+  lowerHelperPriority();
+  findSegments();
+  capSegments();
+  logOpened = time(0);
+  while(true) {
+    bool stopping = stopRotator.load(std::memory_order_acquire);
+    //The segment is only complete once the control thread has switched
+    bool switched = freshFd.load(std::memory_order_acquire) < 0;
+    if(compressing >= 0 && switched) {
+      compressStep();
+      continue;
+    }
+    if(stopping) {
+      break;
+    }
+    if(compressing < 0 && leftoverCount) {
+      startCompressing(leftovers[--leftoverCount]);
+      continue;
+    }
+    long bytes = logFileBytes();
+    if(compressing < 0 && bytes && (bytes >= logRotateBytes || time(0) - logOpened >= logRotateSeconds)) {
+      rotate();
+    }
+    usleep(rotatorPollMicros);
+  }
+  if(compressIn >= 0) {
+    //Left for the next run
+    close(compressIn);
+    close(compressOut);
+  }
+  return NULL;
+}
+
+/*
+writePending:
+  Writes out what is in pendingLog, switching to the rotator's new file first
+  if there is one
+*/
+static void writePending() {
+  int fresh = freshFd.load(std::memory_order_relaxed);
+  if(fresh >= 0) {
+    if(logFd >= 0) {
+      close(logFd);
+    }
+    logFd = fresh;
+    //Everything written to the old file is in it, the rotator can have it
+    freshFd.store(-1, std::memory_order_release);
+  }
+  if(logFd >= 0 && write(logFd, pendingLog, pendingLength) < 0) {
+    //Nothing to be done, the entry is lost
+  }
+  pendingLength = 0;
+  logQueueDepth.store(0, std::memory_order_relaxed);
+}
+
+/*
+stopLog:
+  Writes out everything logged and stops the rotator, at exit
+*/
+static void stopLog() {
+  startLog();
+  if(rotatorRunning) {
+    //Switch to any new file first so the rotator can finish the old one
+    writePending();
+    stopRotator.store(true, std::memory_order_release);
+    pthread_join(rotatorThread, NULL);
+    rotatorRunning = false;
+  }
+  writePending();
+}
+/*
+startLog:
+  Opens the log file, writes out everything logged before it was opened and
+  starts the rotator. Called once the car is moving, and at exit if that
+  never happened.
+*/
+void startLog() {
+  if(logStarted) {
+    return;
+  }
+  logStarted = true;
+  //Create the file if it doesn't exist. If it does, append
+  logFd = open(fileName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if(logFd < 0) {
+    //Can't call errMsg here, it would come back into writeToLog
+    cerr << formatMsg("Error", errFileWrite, "startLog", " - could not open the log file.") << endl;
+    return;
+  }
+  writePending();
+  stopRotator.store(false, std::memory_order_relaxed);
+  if(pthread_create(&rotatorThread, NULL, rotateLogs, NULL) != 0) {
+    cerr << formatMsg("Warning", errThread, "startLog", " - could not start the log rotator.") << endl;
+    return;
+  }
+  rotatorRunning = true;
+}
+/*
+writeToLog:
+  Write the string received as parameter to the log file. Until startLog is
+  called the entry is kept in memory instead, unless that buffer is full.
+*/
+void writeToLog(const char *toLog, int type, const char *extra) {
+  TraceScope trace(traceWriteToLog);
+  time_t now = time(0); //Current time
+  //Into a local buffer, ctime's shared one isn't safe with other threads running
+  char outTime[32];
+  if(!ctime_r(&now, outTime)) {
+    outTime[0] = '\0';
+  }
+  const char *prefix = "";
+  if(type == 0) {
+    prefix = "Entering function ";
+  }
+  else if(type == 1) {
+    prefix = "Leaving function ";
+  }
+  if(!exitHooked) {
+    //Make sure what was kept in memory is written even if the car never moves
+    exitHooked = true;
+    atexit(stopLog);
+  }
+  size_t needed = strlen(outTime) + strlen(prefix) + strlen(toLog) + strlen(extra) + 2;
+  if(needed > (size_t)(pendingLogSize - pendingLength)) {
+    if(!logStarted) {
+      startLog();
+    }
+    writePending();
+  }
+  char *spot = pendingLog + pendingLength;
+  //An entry too long for the buffer is cut short, each part stopping where
+  //there is only room left for the newlines after it
+  char *end = pendingLog + pendingLogSize;
+  spot = appendText(spot, end - 2, outTime);
+  spot = appendText(spot, end - 2, prefix);
+  spot = appendText(spot, end - 2, toLog);
+  *spot++ = '\n';
+  spot = appendText(spot, end - 1, extra);
+  *spot++ = '\n';
+  pendingLength = spot - pendingLog;
+  logQueueDepth.store(pendingLength, std::memory_order_relaxed);
+  if(logStarted) {
+    writePending();
+  }
+}
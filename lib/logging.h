@@ -0,0 +1,49 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <charconv> //For int to char conversion
+#include <system_error> //For errc
+#include "result.h"
+
+/*
+Logging types:
+0 - Into Function
+1 - Out of function
+2 - warnMsg
+3 - errMsg
+4 - other
+
+Each entry is written to log.txt as it is logged. A rotator thread moves the
+file to log.txt.<n> once it passes 256 KB or ten minutes and hands the
+control thread a fresh one, which it switches to at its next entry, then
+compresses the old one to log.txt.<n>.lz4 a block at a time (lz4 -d reads
+it). The oldest segments are deleted to keep the lot under 2 MB. The control
+thread never renames or compresses anything.
+*/
+
+//Name of the log file
+extern const char *fileName;
+
+//Int to char conversion, writes into [first, last) and returns the new end
+template <typename T>
+  char *numberToChars(char *first, char *last, T number) {
+    std::to_chars_result result = std::to_chars(first, last, number);
+    if(result.ec != std::errc()) {
+      return first;
+    }
+    return result.ptr;
+  }
+
+//Text to char copy, writes into [first, last) and returns the new end
+char *appendText(char *first, char *last, const char *text);
+
+//Both print and log the code's errorText along with extra
+void warnMsg(ErrorCode warning, const char *inFunction, const char *extra);
+void errMsg(ErrorCode error, const char *inFunction, const char *extra);
+void writeToLog(const char *toLog, int type, const char *extra);
+//Opens the log file and starts the rotator. Entries before this are kept in
+//memory until it is called, that buffer fills or the program exits.
+void startLog();
+const char *formatMsg(const char *label, ErrorCode error, const char *inFunction, const char *extra);
+
+#endif
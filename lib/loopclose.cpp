@@ -0,0 +1,108 @@
+#include "loopclose.h"
+
+void loopReset(LoopIndex &loops) {
+  for(int i = 0; i < loopTableSize; i++) {
+    loops.table[i].key = 0;
+  }
+  loops.tableCount = 0;
+  loops.windowCount = 0;
+  loops.spotKnown = 0;
+  for(int i = 0; i < frontierMaxNodes; i++) {
+    loops.keptAs[i] = -1;
+  }
+}
+
+/*
+keptNode:
+  The node a node ended up as after any merges
+*/
+static int keptNode(const LoopIndex &loops, int node) {
+  while(loops.keptAs[node] >= 0) {
+    node = loops.keptAs[node];
+  }
+  return node;
+}
+
+/*
+findSlot:
+  Slot holding key, or the empty slot it would go in. Linear probing, the
+  table is never filled past three quarters.
+*/
+static LoopEntry &findSlot(LoopIndex &loops, unsigned long long key) {
+  unsigned int slot = (key * 0x9e3779b97f4a7c15ULL) >> 56 & (loopTableSize - 1);
+  while(loops.table[slot].key && loops.table[slot].key != key) {
+    slot = (slot + 1) & (loopTableSize - 1);
+  }
+  return loops.table[slot];
+}
+
+/*
+nearSpot:
+  Whether two pathSpots are at most loopSpotSlack apart along each axis
+*/
+static bool nearSpot(const int first[2], const int second[2]) {
+  int dx = first[0] - second[0], dy = first[1] - second[1];
+  return dx >= -loopSpotSlack && dx <= loopSpotSlack && dy >= -loopSpotSlack && dy <= loopSpotSlack;
+}
+
+int loopArrive(LoopIndex &loops, FrontierIndex &index, int heading, int spot[2]) {
+  int node = index.current;
+  if(node < 0) {
+    loops.windowCount = 0;
+    return -1;
+  }
+  //Slide the window along, 6 bits an intersection: paths then heading
+  if(loops.windowCount == loopWindow) {
+    for(int i = 1; i < loopWindow; i++) {
+      loops.window[i - 1] = loops.window[i];
+      loops.codes[i - 1] = loops.codes[i];
+    }
+    loops.windowCount --;
+  }
+  loops.window[loops.windowCount] = node;
+  loops.codes[loops.windowCount] = frontierExitMask(index, node) << 2 | heading;
+  loops.windowCount ++;
+  if(!(loops.spotKnown & (1ULL << node))) {
+    loops.spots[node][0] = spot[0];
+    loops.spots[node][1] = spot[1];
+    loops.spotKnown |= 1ULL << node;
+  }
+  if(loops.windowCount < loopWindow) {
+    return -1;
+  }
+  //Keys start at 1 so 0 can mean empty
+  unsigned long long key = 1;
+  for(int i = 0; i < loopWindow; i++) {
+    key = key << 6 | loops.codes[i];
+  }
+  LoopEntry &entry = findSlot(loops, key);
+  if(!entry.key) {
+    if(loops.tableCount < loopTableSize * 3 / 4) {
+      entry.key = key;
+      for(int i = 0; i < loopWindow; i++) {
+        entry.nodes[i] = loops.window[i];
+      }
+      loops.tableCount ++;
+    }
+    return -1;
+  }
+  //Only a node that was just made can be a copy of an old one, and only
+  //if the car thinks it is about where that one was
+  int old = keptNode(loops, entry.nodes[loopWindow - 1]);
+  if(!index.created || old == node || !nearSpot(loops.spots[old], spot)) {
+    return -1;
+  }
+  for(int i = 0; i < loopWindow; i++) {
+    int keep = keptNode(loops, entry.nodes[i]);
+    int drop = keptNode(loops, loops.window[i]);
+    if(keep != drop) {
+      frontierMerge(index, keep, drop);
+      loops.keptAs[drop] = keep;
+    }
+    loops.window[i] = keep;
+  }
+  spot[0] = loops.spots[old][0];
+  spot[1] = loops.spots[old][1];
+  index.created = false;
+  return old;
+}
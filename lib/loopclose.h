@@ -0,0 +1,56 @@
+#ifndef LOOPCLOSE_H
+#define LOOPCLOSE_H
+
+#include "frontier.h"
+
+/*
+Loop closure
+-------------
+The frontier graph and pathSpot only know where the car thinks it is. After
+going round a loop in the maze the car arrives at intersections it has seen
+before as if they were new, and a missed or extra intersection shifts every
+mark after it. To catch that, every arrival adds a signature: the paths at
+the last loopWindow intersections (as compass directions) and the heading
+the car arrived at each one with. Signatures are kept in a fixed size hash
+table, so checking one is a single lookup however big the map gets.
+
+When a new node's signature matches older ones and pathSpot is within
+loopSpotSlack of where it was on the older visit, the car has been here
+before: the new nodes of the window are merged into the old ones
+(frontierMerge) and pathSpot is set back to where it was on the first visit,
+which removes the drift picked up since.
+*/
+
+//Shorter windows match different places in mazes without any loops
+const int loopWindow = 8; //Up to 10, 6 bits each in the key
+//How far pathSpot may have drifted along each axis since the first visit
+//for a match to count
+const int loopSpotSlack = 2;
+const int loopTableSize = 256; //Power of two
+
+struct LoopEntry {
+  unsigned long long key; //0 for an empty slot
+  signed char nodes[loopWindow]; //Oldest first
+};
+
+struct LoopIndex {
+  LoopEntry table[loopTableSize];
+  int tableCount;
+  //The last intersections, oldest first
+  signed char window[loopWindow];
+  unsigned char codes[loopWindow];
+  int windowCount;
+  //pathSpot on the first visit of each node
+  int spots[frontierMaxNodes][2];
+  unsigned long long spotKnown;
+  //Node each merged node went into, -1 if it wasn't merged
+  signed char keptAs[frontierMaxNodes];
+};
+
+void loopReset(LoopIndex &loops);
+//Call after frontierArrive with the heading arrived at and the car's spot.
+//Returns the node the car turned out to be at when a loop was closed (spot
+//is corrected), -1 otherwise.
+int loopArrive(LoopIndex &loops, FrontierIndex &index, int heading, int spot[2]);
+
+#endif
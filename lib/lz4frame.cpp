@@ -0,0 +1,121 @@
+#include <cstring> //For memcpy
+#include "lz4frame.h"
+
+//Positions (plus one, 0 is empty) of the last 4 bytes seen with each hash
+const int lz4HashBits = 12;
+//A match needs 4 bytes, must start 12 bytes before the end of the block and
+//end 5 bytes before it (the format keeps the tail as literals)
+const int lz4MinMatch = 4;
+const int lz4MatchStartLimit = 12;
+const int lz4LastLiterals = 5;
+
+/*
+read32:
+  4 bytes at p as a number, for comparing and hashing
+*/
+static unsigned int read32(const unsigned char *p) {
+  unsigned int value;
+  memcpy(&value, p, 4);
+  return value;
+}
+
+/*
+writeLength:
+  The bytes after a token for a length of 15 or more
+*/
+static unsigned char *writeLength(unsigned char *out, int length) {
+  for(length -= 15; length >= 255; length -= 255) {
+    *out++ = 255;
+  }
+  *out++ = length;
+  return out;
+}
+
+/*
+writeSequence:
+  Literals then a match (matchLength 0 for the last literals of a block)
+*/
+static unsigned char *writeSequence(unsigned char *out, const unsigned char *literals, int literalLength, int offset, int matchLength) {
+  int matchCode = matchLength ? matchLength - lz4MinMatch : 0;
+  *out++ = (literalLength < 15 ? literalLength : 15) << 4 | (matchCode < 15 ? matchCode : 15);
+  if(literalLength >= 15) {
+    out = writeLength(out, literalLength);
+  }
+  memcpy(out, literals, literalLength);
+  out += literalLength;
+  if(matchLength) {
+    *out++ = offset & 0xFF;
+    *out++ = offset >> 8;
+    if(matchCode >= 15) {
+      out = writeLength(out, matchCode);
+    }
+  }
+  return out;
+}
+
+/*
+compressBlock:
+  LZ4 block compression, greedy: each position is looked up once in the hash
+  table and the first match found is taken as far as it goes
+*/
+static int compressBlock(const unsigned char *in, int length, unsigned char *out) {
+  int table[1 << lz4HashBits];
+  memset(table, 0, sizeof(table));
+  unsigned char *spot = out;
+  int anchor = 0;
+  for(int at = 0; at + lz4MatchStartLimit <= length; ) {
+    unsigned int bytes = read32(in + at);
+    unsigned int hash = bytes * 2654435761U >> (32 - lz4HashBits);
+    int candidate = table[hash] - 1;
+    table[hash] = at + 1;
+    if(candidate < 0 || at - candidate > 65535 || read32(in + candidate) != bytes) {
+      at ++;
+      continue;
+    }
+    int matchLength = lz4MinMatch;
+    while(at + matchLength < length - lz4LastLiterals && in[candidate + matchLength] == in[at + matchLength]) {
+      matchLength ++;
+    }
+    spot = writeSequence(spot, in + anchor, at - anchor, at - candidate, matchLength);
+    at += matchLength;
+    anchor = at;
+  }
+  spot = writeSequence(spot, in + anchor, length - anchor, 0, 0);
+  return spot - out;
+}
+
+/*
+write32:
+  Little endian, as the frame format wants
+*/
+static void write32(unsigned char *out, unsigned int value) {
+  out[0] = value;
+  out[1] = value >> 8;
+  out[2] = value >> 16;
+  out[3] = value >> 24;
+}
+
+int lz4FrameHeader(unsigned char *out) {
+  write32(out, 0x184D2204);
+  out[4] = 0x60; //Version 1, independent blocks, no checksums
+  out[5] = 0x40; //Blocks up to 64 KB
+  out[6] = 0x82; //Second byte of the xxHash32 of the two bytes before
+  return lz4HeaderSize;
+}
+
+int lz4FrameBlock(const unsigned char *in, int length, unsigned char *out) {
+  int compressed = compressBlock(in, length, out + 4);
+  if(compressed >= length) {
+    //Stored as is, flagged by the top bit of the size
+    memcpy(out + 4, in, length);
+    write32(out, 0x80000000U | length);
+    return length + 4;
+  }
+  write32(out, compressed);
+  return compressed + 4;
+}
+
+int lz4FrameEnd(unsigned char *out) {
+  write32(out, 0);
+  return lz4EndSize;
+}
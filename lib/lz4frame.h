@@ -0,0 +1,29 @@
+#ifndef LZ4FRAME_H
+#define LZ4FRAME_H
+
+/*
+LZ4 frames
+-----------
+Just enough of the LZ4 frame format to write rotated logs that the stock
+tools read (lz4 -d log.txt.3.lz4): independent blocks of up to 64 KB, no
+checksums, compressed greedily with one hash table lookup a position. There
+is no LZ4 or zstd library on the Omega, and this is small and needs no
+allocation.
+*/
+
+const int lz4BlockSize = 65536;
+//Room a block can take once compressed (incompressible data grows a little)
+const int lz4BoundSize = lz4BlockSize + lz4BlockSize / 255 + 16;
+//Frame header and end mark sizes
+const int lz4HeaderSize = 7;
+const int lz4EndSize = 4;
+
+//Writes the frame header into out, returns its length
+int lz4FrameHeader(unsigned char *out);
+//Compresses length (up to lz4BlockSize) bytes into a framed block in out,
+//which needs lz4BoundSize + 4 bytes. Returns the length written.
+int lz4FrameBlock(const unsigned char *in, int length, unsigned char *out);
+//Writes the end mark into out, returns its length
+int lz4FrameEnd(unsigned char *out);
+
+#endif
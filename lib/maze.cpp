@@ -0,0 +1,623 @@
+#include "maze.h"
+#include "gpio.h"
+#include "sensors.h"
+#include "motors.h"
+#include "logging.h"
+#include "metrics.h"
+#include "trace.h"
+#include "motion.h"
+#include "frontier.h"
+#include "loopclose.h"
+#include "encoder.h"
+#include "estimator.h"
+#include "tuning.h"
+
+MazeMap allPaths;
+int pathSpot[2] = { startWidth, 0 };
+JunctionType lastJunction = junctionNone;
+
+//Bearing planned for the next intersection for each checkAllIR result,
+//negative where checkTremaux would fail
+const unsigned int intersectionPatterns = 8;
+static int plannedBearing[intersectionPatterns];
+//Paths moveForward saw on arriving at an intersection, for intersection
+static bool arrivalRead = false;
+static unsigned int arrivalPaths;
+//Still driving at full speed after going straight through an intersection
+static bool stillMoving = false;
+//Sensor readings since moveForward started
+static JunctionHistory history;
+//Intersections seen so far and the route to the closest unexplored one
+static FrontierIndex frontier;
+//Signatures of the intersections seen, to notice coming back to one
+static LoopIndex loops;
+//Direction the car faces after the last intersection
+static int heading = 0;
+
+/*
+odometer:
+  What corridors are measured in for the frontier index: mm driven, as
+  estimated from the motors and the wheel encoders (see estimator.h)
+*/
+static unsigned long odometer() {
+  return (unsigned long)estimatedDistanceMm();
+}
+/*
+resetMaze:
+  Clears all marks and puts the car back at the entrance
+*/
+void resetMaze() {
+  //All paths set to zero
+  mapReset(allPaths);
+  pathSpot[0] = startWidth;
+  pathSpot[1] = 0;
+  //Set starting spot to 2 so that it doesn't come back out the entrance
+  mapSet(allPaths, pathSpot[0], pathSpot[1], 2);
+  arrivalRead = false;
+  stillMoving = false;
+  frontierReset(frontier);
+  loopReset(loops);
+  heading = 0;
+  estimatorReset(0);
+}
+/*
+markPath:
+  Marks the path spot according to Tremaux's algorithm
+*/
+void markPath() {
+  const char *inFunction = "markPath";
+  writeToLog(inFunction, 0, "");
+  mapMark(allPaths, pathSpot[0], pathSpot[1], 1);
+  writeToLog(inFunction, 1, "");
+}
+/*
+checkNums:
+  Checks the number of marks on the given path spot
+*/
+int checkNums(int spot1, int spot2) {
+  const char *inFunction = "checkNums";
+  writeToLog(inFunction, 0, "");
+  writeToLog(inFunction, 1, "");
+  return mapGet(allPaths, spot1, spot2);
+}
+int tremauxBearing(int left, int straight, int right, int current) {
+  if(left >= 2 && straight >= 2 && right >= 2 && current >= 2) {
+    return -errBadParameter;
+  }
+  if(!left) {
+    //Go left
+    return 1;
+  }
+  else if(!right) {
+    //Go right
+    return 2;
+  }
+  else if(!straight) {
+    //Go straight
+    return 0;
+  }
+  else if(current >= 2){
+    if(right == 1) {
+      //Right
+      return 2;
+    }
+    else if(straight == 1) {
+      //Straight
+      return 0;
+    }
+    else if(left == 1) {
+      //Left
+      return 1;
+    }
+  }
+  else {
+    //Turn around
+    return 3;
+  }
+  return -errUnreachable;
+}
+/*
+checkTremaux:
+  Check all available paths for marks and choose a direction to go (based on algorithm)
+*/
+Result<int> checkTremaux(int left, int straight, int right, int current) {
+  const char *inFunction = "checkTremaux";
+  writeToLog(inFunction, 0, "");
+  int bearing = tremauxBearing(left, straight, right, current);
+  if(bearing == -errBadParameter) {
+    //ERROR
+    errMsg(errBadParameter, inFunction, " - An unexpected number was received as a parameter.");
+    return errBadParameter;
+  }
+  if(bearing == -errUnreachable) {
+    errMsg(errUnreachable, inFunction, " - went past all of the if statements for some reason.");
+    return errUnreachable;
+  }
+  writeToLog(inFunction, 1, "");
+  return bearing;
+}
+/*
+onMap:
+  Whether spot and everything tremauxDecide looks at from it is in the array
+*/
+static bool onMap(const int spot[2]) {
+  return spot[0] >= 1 && spot[0] <= maxWidth - 2 && spot[1] >= 0 && spot[1] <= maxHeight - 3;
+}
+int tremauxDecide(MazeMap &marks, int spot[2], int currentDirection, unsigned int paths, int planned) {
+  if(!onMap(spot)) {
+    return -errOffMap;
+  }
+  //Mark the corner of the path just came out of
+  mapMark(marks, spot[0], spot[1], 1);
+  int turnDirection = planned;
+  if(turnDirection < 0) {
+    //If there is a path, check its marks. Otherwise there is a wall.
+    int left = paths & irLeftPath ? mapGet(marks, spot[0] - 1, spot[1] + 1) : 3;
+    int straight = paths & irFrontPath ? mapGet(marks, spot[0], spot[1] + 2) : 3;
+    int right = paths & irRightPath ? mapGet(marks, spot[0] + 1, spot[1] + 1) : 3;
+    turnDirection = tremauxBearing(left, straight, right, mapGet(marks, spot[0], spot[1]));
+    if(turnDirection < 0) {
+      return turnDirection;
+    }
+  }
+  switch(currentDirection) {
+    case 0: //North
+      if(turnDirection == 1) {
+        spot[0] -= 1;
+        spot[1] += 1;
+      }
+      else if(turnDirection == 2) {
+        spot[0] += 1;
+        spot[1] += 1;
+      }
+      else if(!turnDirection) {
+        spot[1] += 2;
+      }
+      break;
+    case 1: //East
+      if(turnDirection == 1) {
+        spot[1] += 2;
+      }
+      else if(turnDirection == 2) {
+        spot[1] -= 2;
+      }
+      else if(!turnDirection) {
+        spot[0] += 1;
+        spot[1] += 1;
+      }
+      break;
+    case 2: //South
+      if(turnDirection == 2) {
+        spot[0] -= 1;
+        spot[1] += 1;
+      }
+      else if(turnDirection == 1) {
+        spot[0] += 1;
+        spot[1] += 1;
+      }
+      else if(!turnDirection) {
+        spot[1] -= 2;
+      }
+      break;
+    case 3: //West
+      if(turnDirection == 2) {
+        spot[1] += 2;
+      }
+      else if(turnDirection == 1) {
+        spot[1] -= 2;
+      }
+      else if(!turnDirection) {
+        spot[0] -= 1;
+        spot[1] -= 1;
+      }
+      break;
+  }
+  return turnDirection;
+}
+int tremauxArrive(MazeMap &marks, int spot[2], int newDirection, int bearing) {
+  if(spot[0] < 0 || spot[0] >= maxWidth || spot[1] < 0 || spot[1] >= maxHeight) {
+    return -errOffMap;
+  }
+  if(bearing == 3) {
+    //Dead end so mark it twice so that the car doesn't come back down this path.
+    mapMark(marks, spot[0], spot[1], 2);
+    return 0;
+  }
+  mapMark(marks, spot[0], spot[1], 1); //Increment spot in allPaths
+  //Go to next intersection
+  if(newDirection == 1) {
+    spot[0] += 1;
+  }
+  else if(newDirection == 3) {
+    spot[0] -= 1;
+  }
+  else if(newDirection == 0) {
+    spot[1] += 1;
+  }
+  else {
+    spot[1] -= 1;
+  }
+  return 0;
+}
+int turnedDirection(int currentDirection, int turnDirection) {
+  switch(turnDirection) {
+    case 0:
+      //Turn around
+      return (currentDirection + 2) % totalDirections;
+    case 1:
+      //Turn left
+      return (currentDirection + totalDirections - 1) % totalDirections;
+    default:
+      //Turn right
+      return (currentDirection + 1) % totalDirections;
+  }
+}
+/*
+planIntersection:
+  Decides, while still driving down the corridor, what to do at the next
+  intersection for every combination of paths the sensors could find there.
+  moveForward acts on it on arrival, so intersection keeps it even when
+  arriving closes a loop or drops the route.
+*/
+static void planIntersection() {
+  if(!onMap(pathSpot)) {
+    //intersection reports it
+    for(unsigned int paths = 0; paths < intersectionPatterns; paths++) {
+      plannedBearing[paths] = -errOffMap;
+    }
+    return;
+  }
+  //tremauxDecide marks the current spot before deciding
+  int current = mapGet(allPaths, pathSpot[0], pathSpot[1]) + 1;
+  int left = mapGet(allPaths, pathSpot[0] - 1, pathSpot[1] + 1);
+  int straight = mapGet(allPaths, pathSpot[0], pathSpot[1] + 2);
+  int right = mapGet(allPaths, pathSpot[0] + 1, pathSpot[1] + 1);
+  for(unsigned int paths = 0; paths < intersectionPatterns; paths++) {
+    //A route to the frontier comes first, where it can be followed
+    int routed = frontierBearing(frontier, heading, paths);
+    plannedBearing[paths] = routed >= 0 ? routed : tremauxBearing(paths & irLeftPath ? left : 3, paths & irFrontPath ? straight : 3, paths & irRightPath ? right : 3, current);
+  }
+}
+/*
+readSensor:
+  Reads one IR sensor for moveForward, logging which one failed and keeping
+  the reading in the junction history
+*/
+static Result<bool> readSensor(int irDirection, const char *inFunction) {
+  Result<bool> reading = checkIR(irDirection);
+  if(!reading.ok()) {
+    const char *names[] = { " - failed to get front IR reading.", " - failed to get left IR reading.", " - failed to get right IR reading." };
+    errMsg(reading.getError(), inFunction, names[irDirection]);
+    return reading;
+  }
+  //IR direction n is bit n
+  junctionRecord(history, metricsNowMicros(), 1U << irDirection, reading.get());
+  return reading;
+}
+/*
+moveForward
+-----------
+  This function keeps moving the car forward until it detects a path appearing
+  on either the left or right side (only when watchSides is set) or a wall
+  ahead. Returns false at an intersection. It returns true at the end of the
+  maze: when the junction history says so (see junction.h), or failing that
+  after going straight for a certain amount of time (or distance, with the
+  wheel encoders).
+  When watching the sides, the decision for the next intersection is planned
+  on the way, so the car only stops there to turn and doesn't stop at all to
+  go straight.
+*/
+Result<bool> moveForward(bool watchSides) {
+  TraceScope trace(traceMoveForward);
+  const char *inFunction = "moveForward";
+  writeToLog(inFunction, 0, "");
+
+  int done = 0, j = 0;
+  bool finished = false, stretched = false;
+  long startMm = encoderDistanceMm();
+  int stretchLoops = tuning().stretchLoops;
+  unsigned long lastLoop = 0, lastPeriod = 0;
+  //Going straight through keeps the history, so a long stretch with no
+  //lines at all can still be seen as the finish
+  if(!stillMoving) {
+    junctionReset(history, metricsNowMicros(), 0);
+  }
+  //Check initial IR states (checkIR retries each reading itself)
+  Result<bool> reading = readSensor(1, inFunction);
+  if(!reading.ok()) {
+    return reading.getError();
+  }
+  bool irLeft = reading.get();
+  reading = readSensor(2, inFunction);
+  if(!reading.ok()) {
+    return reading.getError();
+  }
+  bool irRight = reading.get();
+  reading = readSensor(0, inFunction);
+  if(!reading.ok()) {
+    return reading.getError();
+  }
+  bool irFront = reading.get();
+  if(watchSides) {
+    planIntersection();
+  }
+
+  //The motor pins were set up as outputs by initialize
+  //Start moving, ramping up to full speed unless the car is already moving
+  Drive drive;
+  Result<void> motors = driveStart(drive, stillMoving);
+  stillMoving = false;
+  if(!motors.ok()) {
+    errMsg(motors.getError(), inFunction, " - failed to set the motors to LOW state.");
+    return motors.getError();
+  }
+  //Continue moving forward until a new pathway is detected
+  do {
+    motors = driveUpdate(drive);
+    if(!motors.ok()) {
+      errMsg(motors.getError(), inFunction, " - failed to set the motors.");
+      return motors.getError();
+    }
+    //Jitter is how much this loop's length differs from the last one
+    unsigned long now = metricsNowMicros();
+    if(lastLoop) {
+      unsigned long period = now - lastLoop;
+      if(lastPeriod) {
+        loopJitter.record(period > lastPeriod ? period - lastPeriod : lastPeriod - period);
+      }
+      lastPeriod = period;
+    }
+    lastLoop = now;
+    if(junctionFinished(history, now)) {
+      finished = true;
+      break;
+    }
+    //Rolled further than any corridor in the maze
+    if(encodersRunning() && encoderDistanceMm() - startMm >= tuning().maxStretchMm) {
+      stretched = true;
+      break;
+    }
+    //The demo only watches the front sensor
+    if(watchSides) {
+      reading = readSensor(1, inFunction);
+      if(!reading.ok()) {
+        return reading.getError();
+      }
+      if(reading.get() != irLeft) {
+        //Some change on the left side
+        if(irLeft) {
+          //A wall appeared. Currently leaving an intersection
+          irLeft = false;
+        }
+        else {
+          //A pathway appeared. Stop and determine where to turn
+          done ++;
+          continue;
+        }
+      }
+      reading = readSensor(2, inFunction);
+      if(!reading.ok()) {
+        return reading.getError();
+      }
+      if(reading.get() != irRight) {
+        //Some change on the right side
+        if(irRight) {
+          //A wall appeared. Currently leaving an intersection
+          irRight = false;
+        }
+        else {
+          //A pathway appeared. Stop and determine where to turn
+          done ++;
+          continue;
+        }
+      }
+    }
+    reading = readSensor(0, inFunction);
+    if(!reading.ok()) {
+      return reading.getError();
+    }
+    if(reading.get()) {
+      //Some change on the front side
+      if(irFront) {
+        //A wall appeared. Currently leaving an intersection
+        irFront = false;
+      }
+      else {
+        //A pathway appeared. Stop and determine where to turn
+        done ++;
+        continue;
+      }
+    }
+    else {
+      //No wall actually appeared before (if it detected one before) so reset variable
+      done = 0;
+    }
+    j ++;
+  } while(done < 2 && j < stretchLoops);
+  stretched = stretched || j == stretchLoops;
+  if(!finished && !stretched) {
+    if(watchSides) {
+      //Look once at everything here, for the plan and the junction type
+      Result<unsigned int> readings = checkAllIR();
+      if(readings.ok()) {
+        arrivalRead = true;
+        arrivalPaths = readings.get();
+        unsigned long now = metricsNowMicros();
+        junctionRecord(history, now, irFrontPath, arrivalPaths & irFrontPath);
+        junctionRecord(history, now, irLeftPath, arrivalPaths & irLeftPath);
+        junctionRecord(history, now, irRightPath, arrivalPaths & irRightPath);
+      }
+    }
+    lastJunction = classifyJunction(history, metricsNowMicros());
+    writeToLog("Junction:", 4, junctionName(lastJunction));
+    finished = lastJunction == junctionFinish;
+  }
+  if(finished || stretched) {
+    //End of maze
+    arrivalRead = false;
+    writeToLog(inFunction, 1, "");
+    return true;
+  }
+  if(arrivalRead) {
+    //Act on the plan straight away
+    int bearing = plannedBearing[arrivalPaths];
+    if(!bearing) {
+      //Keep going
+      stillMoving = true;
+      writeToLog(inFunction, 1, "");
+      return false;
+    }
+    if(bearing > 0) {
+      //Cut the motors so the turn can start, no need to ramp down first
+      motors = retry(tuning().gpioRetry, []() { return applyMotors(motorsStop); });
+      if(!motors.ok()) {
+        errMsg(motors.getError(), inFunction, " - failed to set the motors to HIGH state.");
+        return motors.getError();
+      }
+      //The car coasts to a stop
+      estimatorPredict(motorsStop, 0, motorLagMicros);
+      writeToLog(inFunction, 1, "");
+      return false;
+    }
+  }
+  //Stop moving
+  motors = driveStop(drive);
+  if(!motors.ok()) {
+    errMsg(motors.getError(), inFunction, " - failed to set the motors to HIGH state.");
+    return motors.getError();
+  }
+  writeToLog(inFunction, 1, "");
+  return false;
+}
+/*
+intersection:
+  Calls other functions to check IR sensors for available paths then decides
+  where to go next, then goes in that direction.
+*/
+Result<int> intersection(int currentDirection) {
+  TraceScope trace(traceIntersection);
+  const char *inFunction = "intersection";
+  writeToLog(inFunction, 0, "");
+  //Initial error check
+  if(currentDirection < 0 || currentDirection > 3) {
+    errMsg(errBadParameter, inFunction, " - an unexpected direction was received as a parameter.");
+    return errBadParameter;
+  }
+
+  unsigned long arrived = metricsNowMicros();
+  intersections.add(1);
+
+  unsigned int paths;
+  int planned = -1;
+  if(arrivalRead) {
+    //moveForward already looked and had the decision planned
+    paths = arrivalPaths;
+    planned = plannedBearing[paths];
+    arrivalRead = false;
+  }
+  else {
+    //All three sensors in one read, checkAllIR retries it itself
+    Result<unsigned int> readings = checkAllIR();
+    if(!readings.ok()) {
+      errMsg(readings.getError(), inFunction, " - Failed to get a reading from the IR sensors.");
+      return readings.getError();
+    }
+    paths = readings.get();
+  }
+  frontierArrive(frontier, currentDirection, paths, odometer());
+  //Back somewhere already mapped, pathSpot is put back where it was then
+  if(loopArrive(loops, frontier, currentDirection, pathSpot) >= 0) {
+    loopClosures.add(1);
+    writeToLog("Loop closed", 4, "");
+  }
+  //Follow the route to the closest unexplored path if there is one. A plan
+  //moveForward made is kept as it is, since it may already have driven on
+  //or cut the motors for it.
+  int routed = frontierBearing(frontier, currentDirection, paths);
+  if(routed >= 0 && planned < 0) {
+    planned = routed;
+  }
+  //Using the algorithm decide which direction to turn based on what is available
+  int turnDirection = tremauxDecide(allPaths, pathSpot, currentDirection, paths, planned);
+  if(turnDirection < 0) {
+    ErrorCode error = (ErrorCode)-turnDirection;
+    errMsg(error, inFunction, error == errOffMap ? " - the car has left its map of the maze." : " - could not decide where to go.");
+    return error;
+  }
+  if(turnDirection == 3 && routed < 0) {
+    //Instead of backing out one intersection at a time, head straight for
+    //the closest one with a path not driven yet
+    int steps = frontierPlan(frontier);
+    if(steps >= 0) {
+      char toLog[64];
+      char *spot = appendText(toLog, toLog + sizeof(toLog) - 1, "Route to the frontier: ");
+      spot = numberToChars(spot, toLog + sizeof(toLog) - 12, steps);
+      spot = appendText(spot, toLog + sizeof(toLog) - 1, " junctions");
+      *spot = '\0';
+      writeToLog(toLog, 4, "");
+    }
+  }
+  decisionLatency.record(metricsNowMicros() - arrived);
+  traceDecision(turnDirection, currentDirection);
+  if(turnDirection) {
+    //Bearing 3 is turning around, turn 0
+    Result<int> newDirection = changeDirection(currentDirection, turnDirection == 3 ? 0 : turnDirection);
+    if(!newDirection.ok()) {
+      return newDirection.getError();
+    }
+    currentDirection = newDirection.get();
+  }
+  tremauxArrive(allPaths, pathSpot, currentDirection, turnDirection);
+  frontierLeave(frontier, currentDirection, odometer());
+  //The estimate and the grid should agree on the heading after every turn
+  long off = ((estimatedHeadingDegrees() - currentDirection * 90) % 360 + 540) % 360 - 180;
+  if(off > headingWarnDegrees || off < -headingWarnDegrees) {
+    char toLog[64];
+    char *spot = appendText(toLog, toLog + sizeof(toLog) - 1, "Heading estimate off by ");
+    spot = numberToChars(spot, toLog + sizeof(toLog) - 10, off);
+    spot = appendText(spot, toLog + sizeof(toLog) - 1, " degrees");
+    *spot = '\0';
+    writeToLog(toLog, 4, "");
+  }
+  heading = currentDirection;
+  writeToLog(inFunction, 1, "");
+  return currentDirection;
+}
+/*
+changeDirection:
+  Changes the orientation of the car (to keep track of it) whenever the car
+  turns. The turn is retried according to the turnRetry
+  tuning.
+*/
+Result<int> changeDirection(int currentDirection, int turnDirection) {
+  const char *inFunction = "changeDirection";
+  writeToLog(inFunction, 0, "");
+  //Initial error checking
+  if(currentDirection < 0 || currentDirection > 3) {
+    errMsg(errBadParameter, inFunction, " - an unexpected direction was received.");
+    return errBadParameter;
+  }
+  //Try to turn the car as many times as turnRetry allows
+  Result<void> turned = retry(tuning().turnRetry, [turnDirection, inFunction]() {
+    Result<void> attempt = turn(turnDirection);
+    //If there is an error, output it and try again
+    if(!attempt.ok() && attempt.getError() != errWatchdog) {
+      warnMsg(attempt.getError(), inFunction, " - failed to turn car, trying again.");
+    }
+    return attempt;
+  });
+  if(!turned.ok() && turned.getError() == errWatchdog) {
+    //Part of the turn was done, turning again in full would overshoot, so
+    //give up on it and let the next move find the path
+    errMsg(errWatchdog, inFunction, " - the watchdog cut the turn short, giving up on it.");
+    return errWatchdog;
+  }
+  if(!turned.ok()) {
+    //Out of tries, none worked
+    errMsg(turned.getError(), inFunction, " - failed to turn the car on every retry.");
+    return turned.getError();
+  }
+  //Keep track of the orientation after turning
+  writeToLog(inFunction, 1, "");
+  return turnedDirection(currentDirection, turnDirection);
+}
@@ -0,0 +1,72 @@
+#ifndef MAZE_H
+#define MAZE_H
+
+#include "result.h"
+#include "junction.h"
+#include "mazemap.h"
+
+/*
+DIRECTORY
+------------
+
+Direction:
+0 - NORTH
+1 - EAST
+2 - SOUTH
+3 - WEST
+
+Bearings:
+0 - straight
+1 - Left
+2 - Right
+3 - Turn around
+
+Turning is listed in motors.h, logging types in logging.h
+*/
+
+//Constant global variables declaration
+const int totalDirections = 4;
+//How far moveForward goes without an intersection and the failures in a
+//row carMaze allows are tunable, see tuning.h
+//How far the estimated heading can be from the grid's before it is logged
+//(see estimator.h)
+const long headingWarnDegrees = 30;
+//To keep track of the maze using a spin on Tremaux's algorithm
+const int maxWidth = mapWidth;
+const int maxHeight = mapHeight;
+//Marks per spot, see mazemap.h
+extern MazeMap allPaths;
+//Set starting spot in maze array
+const int startWidth = maxWidth / 2;
+//Current spot in the array
+extern int pathSpot[2];
+//What moveForward made of the last junction it stopped at, see junction.h
+extern JunctionType lastJunction;
+
+void resetMaze();
+Result<int> changeDirection(int currentDirection, int turnDirection);
+void markPath();
+int checkNums(int spot1, int spot2);
+Result<int> checkTremaux(int left, int straight, int right, int current);
+Result<int> intersection(int currentDirection);
+
+/*
+Tremaux bookkeeping
+--------------------
+The part of intersection with no sensors, motors or logging, so it can run
+on allPaths and pathSpot or on copies of them (tools/mazeEval.cpp). Errors
+come back as a negative ErrorCode.
+*/
+//checkTremaux without the logging
+int tremauxBearing(int left, int straight, int right, int current);
+//Marks the corner just left and moves spot for the bearing chosen at an
+//intersection with these paths (checkAllIR bits). planned is used instead of
+//deciding when it isn't negative. Returns the bearing.
+int tremauxDecide(MazeMap &marks, int spot[2], int currentDirection, unsigned int paths, int planned);
+//Finishes the bookkeeping once the car has turned to newDirection
+int tremauxArrive(MazeMap &marks, int spot[2], int newDirection, int bearing);
+//Direction after a turn (turnDirection as for turn in motors.h)
+int turnedDirection(int currentDirection, int turnDirection);
+Result<bool> moveForward(bool watchSides);
+
+#endif
@@ -0,0 +1,16 @@
+#include "mazemap.h"
+#ifdef __SSE2__
+#include <emmintrin.h> //For SSE2
+#endif
+
+void mapReset(MazeMap &map) {
+#ifdef __SSE2__
+  for(int i = 0; i < mapWords; i += 2) {
+    _mm_storeu_si128((__m128i *)&map.words[i], _mm_setzero_si128());
+  }
+#else
+  for(int i = 0; i < mapWords; i++) {
+    map.words[i] = 0;
+  }
+#endif
+}
@@ -0,0 +1,47 @@
+#ifndef MAZEMAP_H
+#define MAZEMAP_H
+
+/*
+Maze map
+---------
+Tremaux's marks for every spot, packed 2 bits a spot: 0, 1 or 2 marks, and
+3 for a wall or 3+ marks. The algorithm treats 2 and more the same, so
+saturating at 3 changes nothing. The whole 20x20 map is 100 bytes instead of
+1600 as ints, so it stays in cache, and clearing it is a handful of 64 bit
+stores, two words at once with SSE2.
+
+Spot (x, y) is number x * mapHeight + y.
+*/
+
+const int mapWidth = 20;
+const int mapHeight = 20;
+const int mapSpots = mapWidth * mapHeight;
+const int mapWordSpots = 32;
+const int mapWords = (mapSpots + mapWordSpots - 1) / mapWordSpots;
+const int mapMostMarks = 3;
+
+struct MazeMap {
+  //Even count so SSE2 can always take two at a time
+  unsigned long long words[mapWords + (mapWords & 1)];
+};
+
+inline int mapGet(const MazeMap &map, int x, int y) {
+  int spot = x * mapHeight + y;
+  return (map.words[spot / mapWordSpots] >> (spot % mapWordSpots * 2)) & 3;
+}
+inline void mapSet(MazeMap &map, int x, int y, int marks) {
+  int spot = x * mapHeight + y;
+  int shift = spot % mapWordSpots * 2;
+  unsigned long long &word = map.words[spot / mapWordSpots];
+  word = (word & ~(3ULL << shift)) | ((unsigned long long)marks << shift);
+}
+//Adds marks, stopping at mapMostMarks
+inline void mapMark(MazeMap &map, int x, int y, int marks) {
+  int total = mapGet(map, x, y) + marks;
+  mapSet(map, x, y, total > mapMostMarks ? mapMostMarks : total);
+}
+
+//Clears every mark
+void mapReset(MazeMap &map);
+
+#endif
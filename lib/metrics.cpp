@@ -0,0 +1,185 @@
+#include <ctime> //For clock_gettime
+#include <cstring> //For strncpy
+#include <pthread.h> //For the server thread
+#include <sys/socket.h> //For the metrics socket
+#include <sys/un.h> //For Unix socket addresses
+#include <unistd.h> //For close
+#include "metrics.h"
+#include "logging.h"
+#include "startup.h"
+
+Counter sensorReads;
+Counter gpioErrors;
+Counter retries;
+Counter intersections;
+Counter loopClosures;
+Counter encoderEdges;
+Counter tuningReloads;
+Histogram decisionLatency;
+Histogram loopJitter;
+Histogram motorSkew;
+Counter watchdogTrips;
+Histogram stopLatency;
+std::atomic<long> logQueueDepth;
+
+static int serverSocket = -1;
+static pthread_t serverThread;
+static char serverPath[108];
+//Only touched by the server thread
+const int metricsBufferSize = 8192;
+static char metricsBuffer[metricsBufferSize];
+
+void Histogram::record(unsigned long micros) {
+  int bucket = 0;
+  while(bucket < histogramBuckets - 1 && micros > (1UL << bucket)) {
+    bucket ++;
+  }
+  counts[bucket].fetch_add(1, std::memory_order_relaxed);
+  sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+unsigned long metricsNowMicros() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+/*
+appendCounter:
+  Writes "# TYPE <name> <type>" and "<name> <value>"
+*/
+static char *appendCounter(char *spot, char *last, const char *name, const char *type, long value) {
+  spot = appendText(spot, last, "# TYPE ");
+  spot = appendText(spot, last, name);
+  spot = appendText(spot, last, " ");
+  spot = appendText(spot, last, type);
+  spot = appendText(spot, last, "\n");
+  spot = appendText(spot, last, name);
+  spot = appendText(spot, last, " ");
+  spot = numberToChars(spot, last, value);
+  return appendText(spot, last, "\n");
+}
+
+/*
+appendHistogram:
+  Writes the histogram with cumulative buckets like Prometheus expects
+*/
+static char *appendHistogram(char *spot, char *last, const char *name, const Histogram &histogram) {
+  unsigned long total = 0;
+  spot = appendText(spot, last, "# TYPE ");
+  spot = appendText(spot, last, name);
+  spot = appendText(spot, last, " histogram\n");
+  for(int i = 0; i < histogramBuckets; i++) {
+    total += histogram.counts[i].load(std::memory_order_relaxed);
+    spot = appendText(spot, last, name);
+    spot = appendText(spot, last, "_bucket{le=\"");
+    if(i < histogramBuckets - 1) {
+      spot = numberToChars(spot, last, 1UL << i);
+    }
+    else {
+      spot = appendText(spot, last, "+Inf");
+    }
+    spot = appendText(spot, last, "\"} ");
+    spot = numberToChars(spot, last, total);
+    spot = appendText(spot, last, "\n");
+  }
+  spot = appendText(spot, last, name);
+  spot = appendText(spot, last, "_sum ");
+  spot = numberToChars(spot, last, histogram.sum.load(std::memory_order_relaxed));
+  spot = appendText(spot, last, "\n");
+  spot = appendText(spot, last, name);
+  spot = appendText(spot, last, "_count ");
+  spot = numberToChars(spot, last, total);
+  return appendText(spot, last, "\n");
+}
+
+int formatMetrics(char *buffer, int size) {
+  char *spot = buffer;
+  char *last = buffer + size;
+  spot = appendCounter(spot, last, "car_sensor_reads_total", "counter", sensorReads.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_gpio_errors_total", "counter", gpioErrors.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_retries_total", "counter", retries.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_intersections_total", "counter", intersections.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_loop_closures_total", "counter", loopClosures.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_encoder_edges_total", "counter", encoderEdges.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_tuning_reloads_total", "counter", tuningReloads.value.load(std::memory_order_relaxed));
+  spot = appendCounter(spot, last, "car_log_queue_bytes", "gauge", logQueueDepth.load(std::memory_order_relaxed));
+  spot = appendHistogram(spot, last, "car_decision_latency_us", decisionLatency);
+  spot = appendHistogram(spot, last, "car_loop_jitter_us", loopJitter);
+  spot = appendHistogram(spot, last, "car_motor_skew_ns", motorSkew);
+  spot = appendCounter(spot, last, "car_watchdog_trips_total", "counter", watchdogTrips.value.load(std::memory_order_relaxed));
+  spot = appendHistogram(spot, last, "car_stop_latency_us", stopLatency);
+  return spot - buffer;
+}
+
+/*
+serveMetrics:
+  Server thread. Answers every connection with the current metrics and
+  closes it. Runs niced so it only takes time the car leaves.
+*/
+static void *serveMetrics(void *) {
+  lowerHelperPriority();
+  while(true) {
+    int client = accept(serverSocket, NULL, NULL);
+    if(client < 0) {
+      //The socket was shut down by stopMetricsServer
+      break;
+    }
+    int length = formatMetrics(metricsBuffer, metricsBufferSize);
+    int sent = 0;
+    while(sent < length) {
+      ssize_t written = write(client, metricsBuffer + sent, length - sent);
+      if(written <= 0) {
+        break;
+      }
+      sent += written;
+    }
+    close(client);
+  }
+  return NULL;
+}
+
+Result<void> startMetricsServer(const char *path) {
+  const char *inFunction = "startMetricsServer";
+  sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if(strlen(path) >= sizeof(address.sun_path)) {
+    warnMsg(errBadParameter, inFunction, " - the socket path is too long.");
+    return errBadParameter;
+  }
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  strncpy(serverPath, path, sizeof(serverPath) - 1);
+  if((serverSocket = socket(AF_UNIX, SOCK_STREAM, 0)) < 0) {
+    warnMsg(errSocket, inFunction, " - could not create the socket.");
+    return errSocket;
+  }
+  //Remove a socket left behind by an earlier run
+  unlink(path);
+  if(bind(serverSocket, (sockaddr *)&address, sizeof(address)) < 0 || listen(serverSocket, 4) < 0) {
+    warnMsg(errSocket, inFunction, " - could not listen on the socket.");
+    close(serverSocket);
+    serverSocket = -1;
+    return errSocket;
+  }
+  if(pthread_create(&serverThread, NULL, serveMetrics, NULL) != 0) {
+    warnMsg(errThread, inFunction, " - could not start the server thread.");
+    close(serverSocket);
+    serverSocket = -1;
+    unlink(path);
+    return errThread;
+  }
+  return Result<void>();
+}
+
+void stopMetricsServer() {
+  if(serverSocket < 0) {
+    return;
+  }
+  //Wakes up the accept in the server thread
+  shutdown(serverSocket, SHUT_RDWR);
+  pthread_join(serverThread, NULL);
+  close(serverSocket);
+  serverSocket = -1;
+  unlink(serverPath);
+}
@@ -0,0 +1,75 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+
+//result.h includes this file for the retry counter, so only declared here
+template <typename T>
+  class Result;
+
+/*
+Metrics
+--------
+Counters and histograms updated by the control loop with relaxed atomic adds,
+so recording never locks or waits. startMetricsServer serves them on a Unix
+socket from a low priority thread in the Prometheus text format, e.g.
+  socat - UNIX-CONNECT:/tmp/carMaze.sock
+*/
+
+//A count that only goes up
+struct Counter {
+  std::atomic<unsigned long> value;
+  void add(unsigned long amount) {
+    value.fetch_add(amount, std::memory_order_relaxed);
+  }
+};
+
+//Values (microseconds unless the name says otherwise) in power of two buckets: bucket i holds values up to
+//2^i us, the last bucket holds everything bigger
+const int histogramBuckets = 20;
+struct Histogram {
+  std::atomic<unsigned long> counts[histogramBuckets];
+  std::atomic<unsigned long> sum;
+  void record(unsigned long micros);
+};
+
+//Successful IR sensor readings
+extern Counter sensorReads;
+//Failed GPIO reads and writes
+extern Counter gpioErrors;
+//Retries done by retry(), not counting first tries
+extern Counter retries;
+//Intersections reached
+extern Counter intersections;
+//Intersections recognised as seen before, see loopclose.h
+extern Counter loopClosures;
+//Wheel encoder edges counted, both wheels, see encoder.h
+extern Counter encoderEdges;
+//Tuning configs published, see tuning.h
+extern Counter tuningReloads;
+//Time from reaching an intersection to deciding where to go
+extern Histogram decisionLatency;
+//Change in length between one moveForward loop and the next
+extern Histogram loopJitter;
+//Nanoseconds between the first and last motor pin changing in one command,
+//only measured by the simulator
+extern Histogram motorSkew;
+//Times the watchdog had to stop the motors, see watchdog.h
+extern Counter watchdogTrips;
+//From when the motors should have stopped (a missed watchdog deadline or an
+//emergency stop signal) to the stop being written to the pins
+extern Histogram stopLatency;
+//Log bytes waiting in memory to be written to the file
+extern std::atomic<long> logQueueDepth;
+
+//Monotonic time in microseconds for timing the control loop
+unsigned long metricsNowMicros();
+//Writes every metric into buffer as text, returns the length written
+int formatMetrics(char *buffer, int size);
+//Starts serving the metrics on a Unix socket at path. Fails with
+//errBadParameter if the path is too long, errSocket or errThread if the
+//socket or thread could not be set up.
+Result<void> startMetricsServer(const char *path);
+void stopMetricsServer();
+
+#endif
@@ -0,0 +1,170 @@
+#include <ctime> //For clock_nanosleep
+#include "motion.h"
+#include "sensors.h"
+#include "metrics.h"
+#include "startup.h"
+#include "estimator.h"
+#include "tuning.h"
+#include "watchdog.h"
+
+static unsigned char rampUp[rampTicks];
+
+const MotionProfile stopProfile = { 0, 0, rampTicks };
+
+void buildMotionProfiles() {
+  //S-curve (smoothstep) from 0 to full duty, its area is half the ramp
+  for(int tick = 0; tick < rampTicks; tick++) {
+    double x = (tick + 0.5) / rampTicks;
+    double speed = x * x * (3 - 2 * x);
+    rampUp[tick] = (unsigned char)(speed * pwmSteps + 0.5);
+  }
+}
+
+MotionProfile turnProfile(long fullMicros) {
+  long fullTicks = fullMicros / motionTickMicros - rampTicks;
+  if(fullTicks < 0) {
+    fullTicks = 0;
+  }
+  MotionProfile profile = { rampTicks, (int)fullTicks, rampTicks };
+  return profile;
+}
+
+/*
+profileDuty:
+  Duty for a tick of a profile
+*/
+static int profileDuty(const MotionProfile &profile, int tick) {
+  if(tick < profile.rampUpTicks) {
+    return rampUp[tick];
+  }
+  tick -= profile.rampUpTicks + profile.fullTicks;
+  if(tick < 0) {
+    return pwmSteps;
+  }
+  return rampUp[profile.rampDownTicks - 1 - tick];
+}
+
+/*
+setMotion:
+  Switches between command and stopped, retrying the write
+*/
+static Result<void> setMotion(MotorCommand command, bool on) {
+  Result<void> motors = retry(tuning().gpioRetry, [command, on]() { return applyMotors(on ? command : motorsStop); });
+  if(motors.ok() && on) {
+    markFirstMotorCommand();
+  }
+  return motors;
+}
+
+/*
+pwmOn:
+  Whether the motors are on at this tick for the given duty
+*/
+static bool pwmOn(int tick, int duty) {
+  return tick % pwmSteps < duty;
+}
+
+/*
+watchPath:
+  Samples the front sensor for runProfile. covered is the distance so far in
+  duty steps (pwmSteps per tick at full speed).
+*/
+static void watchPath(PathWatch *watch, long covered) {
+  if(watch->found >= 0) {
+    return;
+  }
+  Result<bool> path = checkIR(0);
+  if(!path.ok()) {
+    return;
+  }
+  if(watch->lost < 0 && !path.get()) {
+    watch->lost = covered / pwmSteps;
+    estimatorSeeLine(false);
+  }
+  else if(watch->lost >= 0 && path.get()) {
+    watch->found = covered / pwmSteps;
+    estimatorSeeLine(true);
+  }
+}
+
+Result<void> runProfile(MotorCommand command, const MotionProfile &profile, PathWatch *watch) {
+  int ticks = profile.rampUpTicks + profile.fullTicks + profile.rampDownTicks;
+  bool on = false;
+  long covered = 0;
+  if(watch) {
+    watch->lost = -1;
+    watch->found = -1;
+  }
+  timespec next;
+  clock_gettime(CLOCK_MONOTONIC, &next);
+  for(int tick = 0; tick < ticks; tick++) {
+    if(!kickWatchdog()) {
+      setMotion(command, false);
+      return errWatchdog;
+    }
+    int duty = profileDuty(profile, tick);
+    bool wanted = pwmOn(tick, duty);
+    if(wanted != on) {
+      Result<void> motors = setMotion(command, wanted);
+      if(!motors.ok()) {
+        setMotion(command, false);
+        return motors;
+      }
+      on = wanted;
+    }
+    if(watch && tick % pwmSteps == 0) {
+      watchPath(watch, covered);
+    }
+    covered += duty;
+    estimatorPredict(command, duty, motionTickMicros);
+    //Sleep until the next tick, measured from the start so it doesn't drift
+    next.tv_nsec += motionTickMicros * 1000;
+    if(next.tv_nsec >= 1000000000) {
+      next.tv_nsec -= 1000000000;
+      next.tv_sec ++;
+    }
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+  }
+  if(on) {
+    return setMotion(command, false);
+  }
+  return Result<void>();
+}
+
+Result<void> driveStart(Drive &drive, bool atSpeed) {
+  drive.start = metricsNowMicros();
+  drive.last = drive.start;
+  drive.on = atSpeed;
+  if(atSpeed) {
+    //Past the ramp already
+    drive.start -= rampTicks * motionTickMicros;
+  }
+  return driveUpdate(drive);
+}
+
+Result<void> driveUpdate(Drive &drive) {
+  if(!kickWatchdog()) {
+    //The motors are off, start again from stopped next time
+    drive.on = false;
+    return errWatchdog;
+  }
+  unsigned long now = metricsNowMicros();
+  int tick = (now - drive.start) / motionTickMicros;
+  int duty = tick < rampTicks ? rampUp[tick] : pwmSteps;
+  estimatorPredict(motorsForward, duty, now - drive.last);
+  drive.last = now;
+  bool wanted = pwmOn(tick, duty);
+  if(wanted == drive.on) {
+    return Result<void>();
+  }
+  Result<void> motors = setMotion(motorsForward, wanted);
+  if(motors.ok()) {
+    drive.on = wanted;
+  }
+  return motors;
+}
+
+Result<void> driveStop(Drive &drive) {
+  drive.on = false;
+  return runProfile(motorsForward, stopProfile);
+}
@@ -0,0 +1,60 @@
+#ifndef MOTION_H
+#define MOTION_H
+
+#include "result.h"
+#include "motors.h"
+
+/*
+Motion profiles
+----------------
+The motors are either on or off, so speed comes from software PWM at a fixed
+tick rate: on each tick a motor is on if the tick's place in the PWM period
+is below that tick's duty. Starting, stopping and turning follow S-curve
+ramps instead of switching straight to full power, so the wheels don't slip.
+The ramps are tables built once by buildMotionProfiles, so driving only does
+integer math.
+*/
+
+const int motionTickMicros = 1000; //1 kHz
+const int pwmSteps = 10; //Ticks per PWM period, also the duty at full speed
+const int rampTicks = 200; //Time to get from stopped to full speed
+
+//Ramp up, full speed, ramp down, in ticks
+struct MotionProfile {
+  int rampUpTicks;
+  int fullTicks;
+  int rampDownTicks;
+};
+//Full speed down to a stop
+extern const MotionProfile stopProfile;
+
+void buildMotionProfiles();
+//Profile that moves as far as fullMicros at full speed would. The full speed
+//part is longer by one ramp, since the two S-curves together cover one ramp.
+MotionProfile turnProfile(long fullMicros);
+
+//Where the front sensor lost and found a path during a profile, measured in
+//ticks at full speed so ramps count for what they covered. -1 if not seen.
+struct PathWatch {
+  int lost;
+  int found;
+};
+//Runs a whole profile with the motors in command, then stops them. With a
+//watch the front sensor is sampled once per PWM period.
+Result<void> runProfile(MotorCommand command, const MotionProfile &profile, PathWatch *watch = nullptr);
+
+//Driving straight for as long as moveForward wants: driveStart, then
+//driveUpdate as often as possible (at least once a tick), then driveStop
+struct Drive {
+  unsigned long start;
+  unsigned long last; //Last driveUpdate, for the estimator
+  bool on;
+};
+//driveStart with atSpeed carries on at full speed when the motors are
+//already running forward
+Result<void> driveStart(Drive &drive, bool atSpeed = false);
+Result<void> driveUpdate(Drive &drive);
+//Ramps down to a stop
+Result<void> driveStop(Drive &drive);
+
+#endif
@@ -0,0 +1,195 @@
+#include "motors.h"
+#include "gpio.h"
+#include "logging.h"
+#include "trace.h"
+#include "metrics.h"
+#include "motion.h"
+#include "calibration.h"
+#include "encoder.h"
+#include "estimator.h"
+#include "tuning.h"
+#include "watchdog.h"
+
+//Every pin the car uses, and whether initialize requested it (so only those
+//are freed again)
+const int totalPins = 7;
+static bool pinClaimed[totalPins];
+
+/*
+initialize
+----------
+  This function requests every motor and sensor pin once, sets the motors
+  as outputs at high (or off) and the sensors as inputs. The pins stay
+  requested until releasePins is called, so nothing else has to set them up.
+*/
+Result<void> initialize() {
+  const char *inFunction = "initialize";
+  writeToLog(inFunction, 0, "");
+  int pins[totalPins] = { motorFL, motorFR, motorRL, motorRR, sensorLeft, sensorFront, sensorRight };
+  int rq, returnValue;
+  buildMotionProfiles();
+
+  for(int i = 0; i < totalPins; i++) {
+    if((rq = gpio_is_requested(pins[i])) < 0) {
+      //Error
+      errMsg(errGpioRequested, inFunction, " - the GPIO is already requested.");
+      return errGpioRequested;
+    }
+    if(!rq && gpio_request(pins[i], NULL) < 0) {
+      //Error
+      errMsg(errGpioRequest, inFunction, " - the GPIO could not be requested.");
+      return errGpioRequest;
+    }
+    pinClaimed[i] = !rq;
+    //The first four are motors, which start high (off)
+    if(i < 4) {
+      returnValue = gpio_direction_output(pins[i], 1);
+    }
+    else {
+      returnValue = gpio_direction_input(pins[i]);
+    }
+    if(returnValue < 0) {
+      //Error
+      errMsg(errGpioDirection, inFunction, " - the GPIO direction could not be set.");
+      return errGpioDirection;
+    }
+  }
+  writeToLog(inFunction, 1, "");
+  return Result<void>();
+}
+/*
+releasePins:
+  Turns the motors off and frees the pins requested by initialize
+*/
+Result<void> releasePins() {
+  const char *inFunction = "releasePins";
+  writeToLog(inFunction, 0, "");
+  int pins[totalPins] = { motorFL, motorFR, motorRL, motorRR, sensorLeft, sensorFront, sensorRight };
+  ErrorCode error = errNone;
+
+  if(!retry(tuning().gpioRetry, []() { return applyMotors(motorsStop); }).ok()) {
+    errMsg(errGpioWrite, inFunction, " - failed to set motor states to HIGH.");
+    error = errGpioWrite;
+  }
+  for(int i = 0; i < totalPins; i++) {
+    if(pinClaimed[i] && gpio_free(pins[i]) < 0) {
+      errMsg(errGpioFree, inFunction, " - failed to free GPIOs");
+      error = errGpioFree;
+    }
+    pinClaimed[i] = false;
+  }
+  writeToLog(inFunction, 1, "");
+  return error;
+}
+/*
+motorPinValues:
+  Pin values for a motor command. The motors are on when their pin is low.
+*/
+static unsigned int motorPinValues(MotorCommand command) {
+  unsigned int on = 0;
+  switch(command) {
+    case motorsForward:
+      on = Board::MotorFL::mask | Board::MotorFR::mask;
+      break;
+    case motorsTurnLeft:
+      on = Board::MotorRL::mask | Board::MotorFR::mask;
+      break;
+    case motorsTurnRight:
+      on = Board::MotorFL::mask | Board::MotorRR::mask;
+      break;
+    case motorsStop:
+      break;
+  }
+  return motorMask() & ~on;
+}
+
+unsigned int motorMask() {
+  return Board::MotorFL::mask | Board::MotorFR::mask | Board::MotorRL::mask | Board::MotorRR::mask;
+}
+
+/*
+applyMotors:
+  Sets all four motor pins to the command in one write, then reads them back
+  to make sure every pin took the new value. After an emergency stop only
+  motorsStop is written (see watchdog.h).
+*/
+Result<void> applyMotors(MotorCommand command) {
+  unsigned int mask = motorMask();
+  unsigned int values = motorPinValues(command);
+  if(command != motorsStop && emergencyStopped()) {
+    return errEmergencyStop;
+  }
+  encoderDrive(command);
+  watchdogMotors(command != motorsStop);
+  Result<void> written = writePins(mask, values);
+  if(command != motorsStop && emergencyStopped()) {
+    //The signal came in while writing, stop again in case this undid it
+    forcePinsHigh(mask);
+    return errEmergencyStop;
+  }
+  if(!written.ok()) {
+    return written;
+  }
+#ifdef OMEGA_GPIO_SIM
+  //How far apart the pins changed, the simulator keeps the times
+  long long first = 0, last = 0;
+  for(int pin = 0; pin < 32; pin++) {
+    long long changed = simPinChangeTime(pin);
+    if(!(mask & (1U << pin)) || changed < 0) {
+      continue;
+    }
+    if(!first || changed < first) {
+      first = changed;
+    }
+    if(changed > last) {
+      last = changed;
+    }
+  }
+  if(first) {
+    motorSkew.record(last - first);
+  }
+  simClearChangeTimes();
+#endif
+  Result<unsigned int> check = readPins(mask);
+  if(!check.ok()) {
+    return check.getError();
+  }
+  if(check.get() != values) {
+    gpioErrors.add(1);
+    return errGpioWrite;
+  }
+  return Result<void>();
+}
+/*
+turn:
+  Send signals to the motors to turn the car, ramping the speed up and down
+  (see motion.h)
+*/
+Result<void> turn(int turnDirection) {
+  TraceScope trace(traceTurn);
+  const char *inFunction = "turn";
+  writeToLog(inFunction, 0, "");
+  //Initial error checking
+  if(turnDirection < 0 || turnDirection > 2) {
+    errMsg(errBadParameter, inFunction, " - unexpected turn direction received as parameter.");
+    return errBadParameter;
+  }
+  //Turning around is a long left turn
+  MotorCommand command = turnDirection == 2 ? motorsTurnRight : motorsTurnLeft;
+  PathWatch watch;
+  long startAngle = encoderAngleDegrees();
+  estimatorStartTurn(turnDirection);
+  Result<void> motors = runProfile(command, turnProfile(turnMicros[turnDirection]), &watch);
+  if(!motors.ok()) {
+    errMsg(motors.getError(), inFunction, " - failed to set motor states.");
+    return motors.getError();
+  }
+  if(encodersRunning()) {
+    learnTurnAngle(turnDirection, encoderAngleDegrees() - startAngle);
+  }
+  else {
+    learnTurn(turnDirection, watch.lost, watch.found);
+  }
+  writeToLog(inFunction, 1, "");
+  return Result<void>();
+}
@@ -0,0 +1,29 @@
+#ifndef MOTORS_H
+#define MOTORS_H
+
+#include "result.h"
+
+/*
+Turning:
+0 - Turn around
+1 - Left
+2 - Right
+*/
+
+Result<void> initialize();
+Result<void> releasePins();
+
+//Complete states of the four motors
+enum MotorCommand {
+  motorsStop,
+  motorsForward,
+  motorsTurnLeft, //motorRL and motorFR, also used to turn around
+  motorsTurnRight //motorFL and motorRR
+};
+//Pins of all four motors as a mask for writePins
+unsigned int motorMask();
+//Sets all four motor pins in one write and reads them back to check
+Result<void> applyMotors(MotorCommand command);
+Result<void> turn(int turnDirection);
+
+#endif
@@ -0,0 +1,53 @@
+#include "result.h"
+
+const char *errorText(ErrorCode error) {
+  switch(error) {
+    case errNone:
+      return "no error";
+    case errBadParameter:
+      return "unexpected parameter";
+    case errGpioRequested:
+      return "could not check if the GPIO is requested";
+    case errGpioRequest:
+      return "the GPIO could not be requested";
+    case errGpioDirection:
+      return "the GPIO direction could not be set";
+    case errGpioRead:
+      return "could not get a GPIO value";
+    case errGpioWrite:
+      return "could not set a GPIO value";
+    case errGpioFree:
+      return "could not free a GPIO";
+    case errStuck:
+      return "could not move forward";
+    case errUnreachable:
+      return "reached code that should be unreachable";
+    case errOffMap:
+      return "the position is outside the maze array";
+    case errSensorRead:
+      return "no reading from the line array";
+    case errEmergencyStop:
+      return "emergency stop";
+    case errWatchdog:
+      return "the watchdog stopped the motors";
+    case errFileRead:
+      return "could not open the file";
+    case errFileWrite:
+      return "could not write the file";
+    case errThread:
+      return "could not start the thread";
+    case errSocket:
+      return "could not set up the socket";
+    case errTimer:
+      return "could not set up the timer";
+    case errFileWatch:
+      return "could not watch the file";
+    case errMemory:
+      return "could not allocate or lock memory";
+    case errNotBuilt:
+      return "not in this build";
+    case errPinInUse:
+      return "the pin is already used by the board";
+  }
+  return "unknown error";
+}
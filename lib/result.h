@@ -0,0 +1,114 @@
+#ifndef RESULT_H
+#define RESULT_H
+
+#include <unistd.h> //For usleep
+#include "metrics.h"
+
+/*
+Error codes
+------------
+Every function that can fail returns a Result holding either its value or one
+of these. errMsg is given the code, so the same number means the same thing
+everywhere.
+*/
+enum ErrorCode {
+  errNone = 0,
+  errBadParameter = 1, //An unexpected value was received as a parameter
+  errGpioRequested = 2, //Could not check if the GPIO is requested
+  errGpioRequest = 3, //The GPIO could not be requested
+  errGpioDirection = 4, //The GPIO direction could not be set
+  errGpioRead = 5, //Could not get a GPIO value
+  errGpioWrite = 6, //Could not set a GPIO value
+  errGpioFree = 7, //Could not free a GPIO
+  errStuck = 8, //Could not move forward
+  errUnreachable = 9, //Made it somewhere the code should never get to
+  errOffMap = 10, //The car's position is outside the maze array
+  errSensorRead = 11, //No reading from the line array's serial link
+  errEmergencyStop = 12, //The motors were stopped by SIGINT or SIGTERM
+  errWatchdog = 13, //The watchdog stopped the motors, the control thread stalled
+  errFileRead = 14, //A file could not be opened for reading
+  errFileWrite = 15, //A file could not be written
+  errThread = 16, //A helper thread could not be started
+  errSocket = 17, //The metrics socket could not be set up
+  errTimer = 18, //The watchdog timer could not be set up
+  errFileWatch = 19, //A file could not be watched for changes
+  errMemory = 20, //Memory could not be allocated or locked
+  errNotBuilt = 21, //Left out of this build
+  errPinInUse = 22 //The pin is already used by the board for something else
+};
+
+//Short description of an error code
+const char *errorText(ErrorCode error);
+
+/*
+Result:
+  Either a value or an error code, like std::expected. Checking ok() is all
+  the work done on success; nothing is formatted unless there is an error.
+*/
+template <typename T>
+  class Result {
+    public:
+      Result(T value) : value(value), error(errNone) {}
+      Result(ErrorCode error) : value(), error(error) {}
+      bool ok() const {
+        return __builtin_expect(error == errNone, 1);
+      }
+      T get() const {
+        return value;
+      }
+      ErrorCode getError() const {
+        return error;
+      }
+    private:
+      T value;
+      ErrorCode error;
+  };
+
+//For functions that only succeed or fail
+template <>
+  class Result<void> {
+    public:
+      Result() : error(errNone) {}
+      Result(ErrorCode error) : error(error) {}
+      bool ok() const {
+        return __builtin_expect(error == errNone, 1);
+      }
+      ErrorCode getError() const {
+        return error;
+      }
+    private:
+      ErrorCode error;
+  };
+
+//How many times to try something and how long to wait between tries
+struct RetryPolicy {
+  int attempts;
+  long backoffMicros; //Wait before the second try, 0 to retry straight away
+  int backoffFactor; //Each later wait is this many times longer
+};
+//The policies used for GPIO and turns are tunable, see tuning.h
+
+/*
+retry:
+  Calls attempt until it returns a Result that is ok or the policy runs out of
+  attempts, and returns the last Result. At most policy.attempts calls are
+  made, so the worst case cost is known up front. An emergency stop is never
+  retried, it won't go away, and neither is a watchdog stop, since what it
+  cut short was already partly done.
+*/
+template <typename Attempt>
+  auto retry(const RetryPolicy &policy, Attempt attempt) -> decltype(attempt()) {
+    auto result = attempt();
+    long wait = policy.backoffMicros;
+    for(int i = 1; i < policy.attempts && !result.ok() && result.getError() != errEmergencyStop && result.getError() != errWatchdog; i++) {
+      if(wait) {
+        usleep(wait);
+        wait *= policy.backoffFactor;
+      }
+      retries.add(1);
+      result = attempt();
+    }
+    return result;
+  }
+
+#endif
@@ -0,0 +1,123 @@
+#include "sensors.h"
+#include "gpio.h"
+#include "logging.h"
+#include "metrics.h"
+#include "trace.h"
+#include "linearray.h"
+#include "tuning.h"
+
+/*
+readLineArray:
+  Paths as checkAllIR bits from one sample of the line array
+*/
+static Result<unsigned int> readLineArray(const char *inFunction) {
+  LineSample sample;
+  Result<void> reading = sampleLine(sample);
+  if(!reading.ok()) {
+    errMsg(reading.getError(), inFunction, " - failed to read the line array on every retry.");
+    return reading.getError();
+  }
+  sensorReads.add(sample.count);
+  LineShape shape;
+  lineShape(sample, shape);
+  return shape.paths;
+}
+
+/*
+checkIR:
+  Check the values of each of the IR sensors to see if there is a path
+  available. The reading is retried according to the gpioRetry tuning, so
+  callers shouldn't retry again.
+*/
+Result<bool> checkIR(int irDirection) {
+  TraceScope trace(traceCheckIR);
+  const char *inFunction = "checkIR";
+  writeToLog(inFunction, 0, "");
+
+  if(lineArrayOn()) {
+    if(irDirection < 0 || irDirection > 2) {
+      errMsg(errBadParameter, inFunction, " - unexpected IR direction received as parameter.");
+      return errBadParameter;
+    }
+    Result<unsigned int> paths = readLineArray(inFunction);
+    if(!paths.ok()) {
+      return paths.getError();
+    }
+    bool path = paths.get() & (1U << irDirection);
+    traceSensor(irDirection, path);
+    writeToLog(inFunction, 1, "");
+    return path;
+  }
+  //Figure out which sensor is requested, each read is built for its pin.
+  //The pin was set up as an input by initialize.
+  Result<int> reading = errBadParameter;
+  switch(irDirection) {
+    case 0:
+      //Straight
+      reading = retry(tuning().gpioRetry, []() { return readPin<Board::SensorFront>(); });
+      break;
+    case 1:
+      //Left
+      reading = retry(tuning().gpioRetry, []() { return readPin<Board::SensorLeft>(); });
+      break;
+    case 2:
+      //Right
+      reading = retry(tuning().gpioRetry, []() { return readPin<Board::SensorRight>(); });
+      break;
+    default:
+      errMsg(errBadParameter, inFunction, " - unexpected IR direction received as parameter.");
+      return errBadParameter;
+  }
+  if(!reading.ok()) {
+    errMsg(reading.getError(), inFunction, " - failed to get IR sensor value on every retry.");
+    return reading.getError();
+  }
+
+  sensorReads.add(1);
+  traceSensor(irDirection, !reading.get());
+  writeToLog(inFunction, 1, "");
+  //If it senses something there is a wall, otherwise there is a path
+  return !reading.get();
+}
+/*
+checkAllIR:
+  Reads all three IR sensors in one go (a single register load with the
+  register backend) and returns the directions with a path as irFrontPath,
+  irLeftPath and irRightPath bits. Retried according to the gpioRetry
+  tuning.
+*/
+Result<unsigned int> checkAllIR() {
+  TraceScope trace(traceCheckIR);
+  const char *inFunction = "checkAllIR";
+  writeToLog(inFunction, 0, "");
+  if(lineArrayOn()) {
+    Result<unsigned int> paths = readLineArray(inFunction);
+    if(!paths.ok()) {
+      return paths.getError();
+    }
+    for(int i = 0; i < 3; i++) {
+      traceSensor(i, (paths.get() >> i) & 1);
+    }
+    writeToLog(inFunction, 1, "");
+    return paths.get();
+  }
+  const unsigned int mask = Board::SensorFront::mask | Board::SensorLeft::mask | Board::SensorRight::mask;
+  Result<unsigned int> reading = retry(tuning().gpioRetry, [mask]() { return readPins(mask); });
+  if(!reading.ok()) {
+    errMsg(reading.getError(), inFunction, " - failed to get IR sensor values on every retry.");
+    return reading.getError();
+  }
+  sensorReads.add(3);
+  //A sensor that sees a line means a wall, otherwise there is a path
+  unsigned int paths = 0;
+  const int sensors[] = { sensorFront, sensorLeft, sensorRight };
+  for(int i = 0; i < 3; i++) {
+    int path = !(reading.get() & (1U << sensors[i]));
+    traceSensor(i, path);
+    if(path) {
+      paths |= 1U << i;
+    }
+  }
+  writeToLog(inFunction, 1, "");
+  return paths;
+}
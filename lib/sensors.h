@@ -0,0 +1,24 @@
+#ifndef SENSORS_H
+#define SENSORS_H
+
+#include "result.h"
+
+/*
+IR directions:
+0 - Straight
+1 - Left
+2 - Right
+*/
+
+//True if there is a path (no line) in that direction. Both read the line
+//array instead of the three sensors when it is set up (see linearray.h).
+Result<bool> checkIR(int irDirection);
+
+//Bits set by checkAllIR, bit n is IR direction n
+const unsigned int irFrontPath = 1 << 0;
+const unsigned int irLeftPath = 1 << 1;
+const unsigned int irRightPath = 1 << 2;
+//Reads all three sensors at once and returns which directions have a path
+Result<unsigned int> checkAllIR();
+
+#endif
@@ -0,0 +1,71 @@
+#include <ctime> //For clock_gettime
+#include <sys/mman.h> //For mlockall
+#include <sys/resource.h> //For setpriority
+#include <sys/syscall.h> //For the thread id
+#include <unistd.h> //For syscall
+#include "startup.h"
+#include "logging.h"
+
+//Stack the control loop is expected to need, touched before locking memory
+const int stackPrefault = 64 * 1024;
+//How far helper threads are niced, see lowerHelperPriority
+const int helperNice = 10;
+
+/*
+startupNow:
+  Current monotonic time
+*/
+static timespec startupNow() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now;
+}
+
+//Taken when the program is loaded, before main runs
+static timespec processStart = startupNow();
+static long firstMotorMicros = -1;
+
+void prefaultStack() {
+  volatile char stack[stackPrefault];
+  for(int i = 0; i < stackPrefault; i += 256) {
+    stack[i] = 0;
+  }
+  (void)stack;
+}
+
+void lowerHelperPriority() {
+  //Nice is per thread on Linux, so this leaves the rest of the process alone
+  setpriority(PRIO_PROCESS, syscall(SYS_gettid), helperNice);
+}
+
+Result<void> prepareMemory() {
+  prefaultStack();
+  //Globals (maze, log and message buffers) are faulted in and locked here.
+  //Future mappings are left alone so threads started later can still get
+  //their stacks without hitting the lock limit.
+  if(mlockall(MCL_CURRENT) < 0) {
+    warnMsg(errMemory, "prepareMemory", " - the first moves may be slower.");
+    return errMemory;
+  }
+  return Result<void>();
+}
+
+void markFirstMotorCommand() {
+  if(firstMotorMicros >= 0) {
+    return;
+  }
+  timespec now = startupNow();
+  firstMotorMicros = (now.tv_sec - processStart.tv_sec) * 1000000L + (now.tv_nsec - processStart.tv_nsec) / 1000;
+  //The car is moving, so the log file can be opened now
+  char toLog[64];
+  char *spot = appendText(toLog, toLog + sizeof(toLog) - 1, "Time to first motor command: ");
+  spot = numberToChars(spot, toLog + sizeof(toLog) - 4, firstMotorMicros);
+  spot = appendText(spot, toLog + sizeof(toLog) - 1, " us");
+  *spot = '\0';
+  writeToLog(toLog, 4, "");
+  startLog();
+}
+
+long timeToFirstMotorCommand() {
+  return firstMotorMicros;
+}
@@ -0,0 +1,22 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include "result.h"
+
+//Pre-faults the stack and locks the program's memory so the first moves of
+//the car don't wait on page faults. Fails with errMemory if the memory could
+//not be locked (the car can still run).
+Result<void> prepareMemory();
+//Touches the stack the calling thread will use so its pages already exist
+void prefaultStack();
+//Nices the calling helper thread (log rotator, metrics server, tuning
+//watcher) below the control loop. Not SCHED_IDLE: the control loop never
+//sleeps, so on one core an idle thread would never run.
+void lowerHelperPriority();
+//Called after every motor command that starts the car moving. The first call
+//records and logs the time since the program started and opens the log file.
+void markFirstMotorCommand();
+//Microseconds from program start to the first motor command, -1 until then
+long timeToFirstMotorCommand();
+
+#endif
@@ -0,0 +1,275 @@
+#include <atomic> //For handing out tables
+#include <csignal> //For SIGUSR1
+#include <cstdio> //For writing the timeline
+#include <cstdlib> //For calloc
+#include <cstring> //For memset
+#include <fcntl.h> //For open
+#include <unistd.h> //For write
+#include "trace.h"
+#include "logging.h"
+
+//One table per thread that records, taken from a fixed pool so recording
+//never allocates. Threads past the pool size aren't traced.
+const int traceMaxThreads = 4;
+struct TraceTable {
+  TraceHistogram histograms[tracePoints];
+};
+static TraceTable traceTables[traceMaxThreads];
+static std::atomic<int> traceTablesUsed(0);
+static thread_local TraceTable *localTable = NULL;
+static thread_local bool localTableFull = false;
+
+static const char *traceNames[tracePoints] = { "checkIR", "turn", "intersection", "moveForward", "readPin", "writePin", "writeToLog", "estimatorPredict" };
+
+//Timeline events, allocated once by traceStartTimeline
+struct TimelineEvent {
+  unsigned long long start;
+  unsigned long long duration;
+  short kind;
+  short id;
+  int value;
+};
+bool timelineOn = false;
+static TimelineEvent *timelineEvents = NULL;
+static int timelineSize = 0;
+static std::atomic<int> timelineUsed(0);
+static unsigned long long timelineBase = 0;
+static const char *timelinePath = NULL;
+static int lastSensor[3] = { -1, -1, -1 };
+
+/*
+traceBucket:
+  Which bucket of a TraceHistogram nanos goes in
+*/
+static int traceBucket(unsigned long long nanos) {
+  if(nanos < (unsigned long long)traceSubBuckets) {
+    return (int)nanos;
+  }
+  int highBit = 63 - __builtin_clzll(nanos);
+  int major = highBit - 2;
+  if(major >= traceMajorBuckets) {
+    return traceMajorBuckets * traceSubBuckets - 1;
+  }
+  int sub = (nanos >> (highBit - 3)) & (traceSubBuckets - 1);
+  return major * traceSubBuckets + sub;
+}
+
+#ifdef OMEGA_TRACE
+/*
+traceBucketValue:
+  Smallest value that goes in bucket
+*/
+static unsigned long long traceBucketValue(int bucket) {
+  int major = bucket / traceSubBuckets;
+  int sub = bucket % traceSubBuckets;
+  if(!major) {
+    return sub;
+  }
+  return (unsigned long long)(traceSubBuckets + sub) << (major - 1);
+}
+#endif
+
+void traceRecord(TracePoint point, unsigned long long nanos) {
+  if(!localTable) {
+    if(localTableFull) {
+      return;
+    }
+    int spot = traceTablesUsed.fetch_add(1);
+    if(spot >= traceMaxThreads) {
+      localTableFull = true;
+      return;
+    }
+    localTable = &traceTables[spot];
+  }
+  TraceHistogram &histogram = localTable->histograms[point];
+  histogram.counts[traceBucket(nanos)] ++;
+  histogram.total ++;
+  if(nanos > histogram.max) {
+    histogram.max = nanos;
+  }
+}
+
+#ifdef OMEGA_TRACE
+/*
+tracePercentile:
+  Value below which the given per mille of the merged samples fall
+*/
+static unsigned long long tracePercentile(const TraceHistogram &histogram, int perMille) {
+  unsigned long wanted = (histogram.total * perMille + 999) / 1000;
+  unsigned long seen = 0;
+  for(int i = 0; i < traceMajorBuckets * traceSubBuckets; i++) {
+    seen += histogram.counts[i];
+    if(seen >= wanted && seen) {
+      return traceBucketValue(i);
+    }
+  }
+  return histogram.max;
+}
+#endif
+
+void traceWriteReport(const char *path) {
+#ifdef OMEGA_TRACE
+  //Static so the signal handler doesn't need a big stack
+  static TraceHistogram merged;
+  static char report[2048];
+  int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if(fd < 0) {
+    return;
+  }
+  char *spot = report;
+  char *last = report + sizeof(report);
+  spot = appendText(spot, last, "function count p50_ns p90_ns p99_ns max_ns\n");
+  int used = traceTablesUsed.load();
+  if(used > traceMaxThreads) {
+    used = traceMaxThreads;
+  }
+  for(int point = 0; point < tracePoints; point++) {
+    merged = TraceHistogram();
+    for(int table = 0; table < used; table++) {
+      const TraceHistogram &histogram = traceTables[table].histograms[point];
+      for(int i = 0; i < traceMajorBuckets * traceSubBuckets; i++) {
+        merged.counts[i] += histogram.counts[i];
+      }
+      merged.total += histogram.total;
+      if(histogram.max > merged.max) {
+        merged.max = histogram.max;
+      }
+    }
+    const int perMille[] = { 500, 900, 990 };
+    spot = appendText(spot, last, traceNames[point]);
+    spot = appendText(spot, last, " ");
+    spot = numberToChars(spot, last, merged.total);
+    for(int i = 0; i < 3; i++) {
+      spot = appendText(spot, last, " ");
+      spot = numberToChars(spot, last, tracePercentile(merged, perMille[i]));
+    }
+    spot = appendText(spot, last, " ");
+    spot = numberToChars(spot, last, merged.max);
+    spot = appendText(spot, last, "\n");
+  }
+  if(write(fd, report, spot - report) < 0) {
+    //Nothing else to do from a signal handler
+  }
+  close(fd);
+#else
+  //Nothing was recorded
+  (void)path;
+#endif
+}
+
+#ifdef OMEGA_TRACE
+static const char *reportPath = "trace.txt";
+
+/*
+traceSignal:
+  SIGUSR1 handler
+*/
+static void traceSignal(int) {
+  traceWriteReport(reportPath);
+}
+#endif
+
+void traceInstallSignal(const char *path) {
+#ifdef OMEGA_TRACE
+  reportPath = path;
+  struct sigaction action = {};
+  action.sa_handler = traceSignal;
+  action.sa_flags = SA_RESTART;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGUSR1, &action, NULL);
+#else
+  (void)path;
+#endif
+}
+
+Result<void> traceStartTimeline(const char *path, int maxEvents) {
+#ifdef OMEGA_TRACE
+  timelineEvents = (TimelineEvent *)calloc(maxEvents, sizeof(TimelineEvent));
+  if(!timelineEvents) {
+    warnMsg(errMemory, "traceStartTimeline", " - could not allocate the timeline.");
+    return errMemory;
+  }
+  //Touch every page now so recording doesn't fault later
+  memset(timelineEvents, 0, maxEvents * sizeof(TimelineEvent));
+  timelineSize = maxEvents;
+  timelinePath = path;
+  timelineBase = traceNow();
+  timelineOn = true;
+  return Result<void>();
+#else
+  warnMsg(errNotBuilt, "traceStartTimeline", " - built without OMEGA_TRACE, there is no timeline.");
+  (void)path;
+  (void)maxEvents;
+  return errNotBuilt;
+#endif
+}
+
+void timelineAdd(TimelineKind kind, int id, int value, unsigned long long start, unsigned long long duration) {
+  int spot = timelineUsed.fetch_add(1, std::memory_order_relaxed);
+  if(spot >= timelineSize) {
+    return;
+  }
+  TimelineEvent &event = timelineEvents[spot];
+  event.start = start;
+  event.duration = duration;
+  event.kind = kind;
+  event.id = id;
+  event.value = value;
+}
+
+void timelineSensorChange(int irDirection, int value) {
+  if(irDirection < 0 || irDirection > 2 || lastSensor[irDirection] == value) {
+    return;
+  }
+  lastSensor[irDirection] = value;
+  timelineAdd(timelineSensor, irDirection, value, traceNow(), 0);
+}
+
+void traceWriteTimeline() {
+  if(!timelineOn) {
+    return;
+  }
+  timelineOn = false;
+  FILE *out = fopen(timelinePath, "w");
+  if(!out) {
+    warnMsg(errFileWrite, "traceWriteTimeline", " - could not open the timeline file.");
+    return;
+  }
+  const char *sensorNames[] = { "sensor front", "sensor left", "sensor right" };
+  const char *turnNames[] = { "straight", "left", "right", "turn around" };
+  int used = timelineUsed.load();
+  int dropped = 0;
+  if(used > timelineSize) {
+    dropped = used - timelineSize;
+    used = timelineSize;
+  }
+  fprintf(out, "{\"traceEvents\":[\n");
+  for(int i = 0; i < used; i++) {
+    const TimelineEvent &event = timelineEvents[i];
+    //Chrome wants microseconds
+    double ts = (event.start - timelineBase) / 1000.0;
+    const char *comma = i < used - 1 ? "," : "";
+    switch(event.kind) {
+      case timelineSpan:
+        fprintf(out, "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}%s\n",
+          traceNames[event.id], ts, event.duration / 1000.0, comma);
+        break;
+      case timelineSensor:
+        fprintf(out, "{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"path\":%d}}%s\n",
+          sensorNames[event.id], ts, event.value, comma);
+        break;
+      case timelinePin:
+        fprintf(out, "{\"name\":\"pin %d\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"value\":%d}}%s\n",
+          event.id, ts, event.value, comma);
+        break;
+      case timelineDecision:
+        fprintf(out, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"args\":{\"heading\":%d}}%s\n",
+          turnNames[event.id & 3], ts, event.value, comma);
+        break;
+    }
+  }
+  fprintf(out, "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":%d}}\n", dropped);
+  fclose(out);
+  free(timelineEvents);
+  timelineEvents = NULL;
+}
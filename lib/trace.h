@@ -0,0 +1,124 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <ctime> //For clock_gettime
+#include "result.h"
+
+/*
+Tracing
+--------
+Put a TraceScope at the top of a function and the time until it returns is
+added to that function's latency histogram. Histograms are kept per thread
+and merged when the report is written, at the end of the run or when the
+program gets SIGUSR1. Only built in with -DOMEGA_TRACE=ON, otherwise
+TraceScope does nothing.
+
+Timeline
+---------
+Once traceStartTimeline is called, function spans, sensor changes, pin
+writes and navigation decisions are also kept in an event buffer allocated
+up front. traceWriteTimeline writes them out at the end of the run as Chrome
+trace-event JSON, to open in chrome://tracing or ui.perfetto.dev. Events past
+the end of the buffer are dropped and counted.
+*/
+
+//Traced functions
+enum TracePoint {
+  traceCheckIR,
+  traceTurn,
+  traceIntersection,
+  traceMoveForward,
+  traceReadPin,
+  traceWritePin,
+  traceWriteToLog,
+  traceEstimator,
+  tracePoints
+};
+
+//HDR style histogram of nanoseconds: values under 8 get their own bucket,
+//after that every power of two is split into 8 buckets (about 12% apart)
+const int traceSubBuckets = 8;
+const int traceMajorBuckets = 40;
+struct TraceHistogram {
+  unsigned long counts[traceMajorBuckets * traceSubBuckets];
+  unsigned long total;
+  unsigned long long max;
+};
+
+//Adds nanos to the calling thread's histogram for point
+void traceRecord(TracePoint point, unsigned long long nanos);
+//Writes count, percentiles and max for every traced function. Only uses
+//async-signal-safe calls so it can be run from the signal handler.
+void traceWriteReport(const char *path);
+//Writes the report to path whenever SIGUSR1 is received
+void traceInstallSignal(const char *path);
+
+//Allocates room for maxEvents and starts recording the timeline. Fails with
+//errMemory if the buffer could not be allocated, errNotBuilt without
+//OMEGA_TRACE.
+Result<void> traceStartTimeline(const char *path, int maxEvents);
+//Writes the timeline to the path given to traceStartTimeline
+void traceWriteTimeline();
+
+enum TimelineKind {
+  timelineSpan, //id is a TracePoint
+  timelineSensor, //id is the IR direction, value the new reading
+  timelinePin, //id is the pin, value what was written
+  timelineDecision //id is the turn direction, value the heading before it
+};
+extern bool timelineOn;
+void timelineAdd(TimelineKind kind, int id, int value, unsigned long long start, unsigned long long duration);
+
+//Nanoseconds, 64 bits even on the 32 bit Omega
+inline unsigned long long traceNow() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+#ifdef OMEGA_TRACE
+class TraceScope {
+  public:
+    TraceScope(TracePoint point) : point(point), start(traceNow()) {}
+    ~TraceScope() {
+      unsigned long long end = traceNow();
+      traceRecord(point, end - start);
+      if(timelineOn) {
+        timelineAdd(timelineSpan, point, 0, start, end - start);
+      }
+    }
+  private:
+    TracePoint point;
+    unsigned long long start;
+};
+
+//Sensor readings are only added to the timeline when they change
+void timelineSensorChange(int irDirection, int value);
+
+inline void traceSensor(int irDirection, int value) {
+  if(timelineOn) {
+    timelineSensorChange(irDirection, value);
+  }
+}
+inline void tracePin(int pin, int value) {
+  if(timelineOn) {
+    timelineAdd(timelinePin, pin, value, traceNow(), 0);
+  }
+}
+inline void traceDecision(int turnDirection, int heading) {
+  if(timelineOn) {
+    timelineAdd(timelineDecision, turnDirection, heading, traceNow(), 0);
+  }
+}
+#else
+class TraceScope {
+  public:
+    TraceScope(TracePoint) {}
+};
+
+inline void traceSensor(int, int) {}
+inline void tracePin(int, int) {}
+inline void traceDecision(int, int) {}
+#endif
+
+#endif
@@ -0,0 +1,203 @@
+#include <cstdio> //For reading the config file
+#include <cstring> //For strcmp
+#include <poll.h> //For waiting on the watch
+#include <pthread.h> //For the watcher thread
+#include <sys/inotify.h> //For watching the config file
+#include <unistd.h> //For read and close
+#include "tuning.h"
+#include "metrics.h"
+#include "logging.h"
+#include "startup.h"
+
+const Tuning defaultTuning = {
+  5, //maxLength
+  10000, //stretchLoops
+  3000, //maxStretchMm
+  { 5, 0, 1 }, //gpioRetry, straight away
+  { 5, 1000000, 1 } //turnRetry, one second apart
+};
+std::atomic<const Tuning *> publishedTuning(&defaultTuning);
+
+//The two copies the published pointer moves between
+static Tuning copies[2];
+//Bumped on every publish, and the newest one the control thread has seen
+static std::atomic<unsigned long> publishedGeneration(0);
+static std::atomic<unsigned long> seenGeneration(0);
+
+static std::atomic<bool> stopWatch;
+static pthread_t watchThread;
+static int watchFd = -1;
+//The file watched, and the directory and name inotify reports it by
+static char watchPath[256];
+static char watchName[128];
+//How long the watcher waits for events or the control thread before
+//checking whether to stop
+const int tuningPollMillis = 100;
+
+/*
+readTuning:
+  Reads the file over the defaults. Fails with errFileRead if it can't be
+  opened.
+*/
+static Result<void> readTuning(const char *path, Tuning &into) {
+  into = defaultTuning;
+  FILE *in = fopen(path, "r");
+  if(!in) {
+    return errFileRead;
+  }
+  char line[128];
+  char name[32];
+  long value;
+  while(fgets(line, sizeof(line), in)) {
+    if(line[0] == '#' || sscanf(line, "%31s %ld", name, &value) != 2 || value < 0) {
+      continue;
+    }
+    if(!strcmp(name, "turnBackoffMicros")) {
+      into.turnRetry.backoffMicros = value;
+    }
+    else if(!value || value > 100000000) {
+      //Everything else has to be at least 1
+      continue;
+    }
+    else if(!strcmp(name, "maxLength")) {
+      into.maxLength = value;
+    }
+    else if(!strcmp(name, "stretchLoops")) {
+      into.stretchLoops = value;
+    }
+    else if(!strcmp(name, "maxStretchMm")) {
+      into.maxStretchMm = value;
+    }
+    else if(!strcmp(name, "gpioAttempts")) {
+      into.gpioRetry.attempts = value;
+    }
+    else if(!strcmp(name, "turnAttempts")) {
+      into.turnRetry.attempts = value;
+    }
+  }
+  fclose(in);
+  return Result<void>();
+}
+
+/*
+publish:
+  Copies config into whichever copy isn't published and swaps the pointer to
+  it. The control thread may still hold that copy from before the last swap,
+  so this first waits for it to have seen the newest config. Returns false
+  if stopWatch was set while waiting.
+*/
+static bool publish(const Tuning &config) {
+  while(seenGeneration.load(std::memory_order_acquire) != publishedGeneration.load(std::memory_order_relaxed)) {
+    if(stopWatch.load(std::memory_order_relaxed)) {
+      return false;
+    }
+    usleep(tuningPollMillis * 1000);
+  }
+  Tuning *spare = publishedTuning.load(std::memory_order_relaxed) == &copies[0] ? &copies[1] : &copies[0];
+  *spare = config;
+  publishedTuning.store(spare, std::memory_order_release);
+  publishedGeneration.fetch_add(1, std::memory_order_release);
+  tuningReloads.add(1);
+  return true;
+}
+
+Result<void> loadTuning(const char *path) {
+  Tuning config;
+  Result<void> read = readTuning(path, config);
+  if(!read.ok()) {
+    return read;
+  }
+  publish(config);
+  //This is the control thread, so it has seen it
+  tuningQuiescent();
+  return Result<void>();
+}
+
+/*
+watchTuning:
+  Watcher thread. Rereads the file whenever it is written or replaced (which
+  is how most editors save) and publishes it.
+*/
+static void *watchTuning(void *) {
+  lowerHelperPriority();
+  alignas(inotify_event) char events[4096];
+  while(!stopWatch.load(std::memory_order_relaxed)) {
+    pollfd waiting = { watchFd, POLLIN, 0 };
+    if(poll(&waiting, 1, tuningPollMillis) <= 0) {
+      continue;
+    }
+    ssize_t length = read(watchFd, events, sizeof(events));
+    bool changed = false;
+    for(ssize_t spot = 0; spot < length; ) {
+      inotify_event *event = (inotify_event *)(events + spot);
+      if(event->len && !strcmp(event->name, watchName)) {
+        changed = true;
+      }
+      spot += sizeof(inotify_event) + event->len;
+    }
+    Tuning config;
+    if(changed && readTuning(watchPath, config).ok()) {
+      publish(config);
+    }
+  }
+  return NULL;
+}
+
+Result<void> startTuningWatch(const char *path) {
+  const char *inFunction = "startTuningWatch";
+  //inotify watches the directory, since editors replace the file
+  char directory[256];
+  const char *slash = strrchr(path, '/');
+  if(strlen(path) >= sizeof(watchPath) || strlen(slash ? slash + 1 : path) >= sizeof(watchName)) {
+    warnMsg(errBadParameter, inFunction, " - the config path is too long.");
+    return errBadParameter;
+  }
+  strcpy(watchPath, path);
+  strcpy(watchName, slash ? slash + 1 : path);
+  if(slash == path) {
+    strcpy(directory, "/");
+  }
+  else if(slash) {
+    memcpy(directory, path, slash - path);
+    directory[slash - path] = '\0';
+  }
+  else {
+    strcpy(directory, ".");
+  }
+  if((watchFd = inotify_init1(IN_CLOEXEC)) < 0 || inotify_add_watch(watchFd, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+    warnMsg(errFileWatch, inFunction, " - changes to the config need a restart.");
+    if(watchFd >= 0) {
+      close(watchFd);
+      watchFd = -1;
+    }
+    return errFileWatch;
+  }
+  stopWatch.store(false, std::memory_order_relaxed);
+  if(pthread_create(&watchThread, NULL, watchTuning, NULL) != 0) {
+    warnMsg(errThread, inFunction, " - could not start the watcher thread.");
+    close(watchFd);
+    watchFd = -1;
+    return errThread;
+  }
+  return Result<void>();
+}
+
+void stopTuningWatch() {
+  if(watchFd < 0) {
+    return;
+  }
+  stopWatch.store(true, std::memory_order_relaxed);
+  pthread_join(watchThread, NULL);
+  close(watchFd);
+  watchFd = -1;
+}
+
+bool tuningQuiescent() {
+  unsigned long newest = publishedGeneration.load(std::memory_order_acquire);
+  unsigned long seen = seenGeneration.load(std::memory_order_relaxed);
+  if(newest == seen) {
+    return false;
+  }
+  seenGeneration.store(newest, std::memory_order_release);
+  return true;
+}
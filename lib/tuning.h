@@ -0,0 +1,52 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <atomic>
+#include "result.h"
+
+/*
+Tuning
+-------
+Values worth changing between runs without building again. They are read
+from a config file at startup and again whenever it changes, watched with
+inotify from a niced thread. Lines are `<name> <value>` with the names of
+the fields below (gpioAttempts, turnAttempts and turnBackoffMicros
+for the retry policies), # starts a comment, and anything missing or out of
+range keeps its default.
+
+The watcher never writes a config the control thread might be reading: it
+fills in a spare copy and swaps the published pointer to it, RCU style, so
+tuning() is one atomic load and always sees a whole config. The copy it
+replaced is only reused once the control thread has called tuningQuiescent,
+its promise that it holds no reference older than the newest config.
+*/
+
+struct Tuning {
+  int maxLength; //Failed moves in a row before carMaze gives up
+  int stretchLoops; //moveForward loops without an intersection before it is the end
+  long maxStretchMm; //The same in mm, when the wheel encoders are running
+  RetryPolicy gpioRetry; //GPIO reads and writes
+  RetryPolicy turnRetry; //Turns
+};
+extern const Tuning defaultTuning;
+extern std::atomic<const Tuning *> publishedTuning;
+
+//The current config, only good until the next tuningQuiescent
+inline const Tuning &tuning() {
+  return *publishedTuning.load(std::memory_order_acquire);
+}
+
+//Reads the file and publishes it, from the control thread. Fails with
+//errFileRead if the file could not be read, keeping the defaults.
+Result<void> loadTuning(const char *path);
+//Starts watching the file for changes. Fails with errBadParameter if the
+//path is too long, errFileWatch or errThread if the watch or thread could
+//not be set up.
+Result<void> startTuningWatch(const char *path);
+void stopTuningWatch();
+//Called by the control thread between steps, when it holds no reference from
+//tuning(). Returns true if a newer config has been published since the last
+//call.
+bool tuningQuiescent();
+
+#endif
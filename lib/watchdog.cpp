@@ -0,0 +1,140 @@
+#include <atomic>
+#include <csignal> //For SIGINT and SIGTERM
+#include <pthread.h> //For the watchdog thread
+#include <sched.h> //For SCHED_FIFO
+#include <sys/timerfd.h> //For the watchdog's tick
+#include <unistd.h> //For read and close
+#include "watchdog.h"
+#include "gpio.h"
+#include "motors.h"
+#include "metrics.h"
+#include "logging.h"
+
+//Monotonic microseconds of the last kick
+static std::atomic<unsigned long> lastKick(0);
+//Commands written so far shifted up one, with the low bit set if the last
+//one left any motor on. The count lets the watchdog tell whether a command
+//came in while it was stopping the motors.
+static std::atomic<unsigned long> motorState(0);
+static unsigned long commands = 0;
+//Set by the watchdog when it stops the motors, cleared by kickWatchdog
+static std::atomic<bool> fired(false);
+static volatile sig_atomic_t stopped = 0;
+
+static std::atomic<bool> stopDog;
+static pthread_t dogThread;
+static int timerFd = -1;
+static bool running = false;
+//Above the encoder reader
+const int watchdogPriority = 2;
+
+bool kickWatchdog() {
+  lastKick.store(metricsNowMicros(), std::memory_order_relaxed);
+  if(__builtin_expect(fired.load(std::memory_order_relaxed), 0)) {
+    fired.store(false, std::memory_order_relaxed);
+    return false;
+  }
+  return true;
+}
+
+void watchdogMotors(bool on) {
+  lastKick.store(metricsNowMicros(), std::memory_order_relaxed);
+  commands ++;
+  motorState.store(commands << 1 | (on ? 1 : 0), std::memory_order_release);
+}
+
+bool emergencyStopped() {
+  return stopped;
+}
+
+/*
+watchMotors:
+  Watchdog thread. Wakes every watchdogTickMicros and forces the motors off
+  if they are on and the last kick is older than watchdogPeriodMicros.
+*/
+static void *watchMotors(void *) {
+  sched_param param;
+  param.sched_priority = watchdogPriority;
+  pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+  while(!stopDog.load(std::memory_order_relaxed)) {
+    unsigned long long expirations;
+    if(read(timerFd, &expirations, sizeof(expirations)) < 0) {
+      continue;
+    }
+    unsigned long state = motorState.load(std::memory_order_acquire);
+    if(!(state & 1)) {
+      continue;
+    }
+    unsigned long due = lastKick.load(std::memory_order_relaxed) + watchdogPeriodMicros;
+    unsigned long now = metricsNowMicros();
+    if((long)(now - due) <= 0) {
+      continue;
+    }
+    forcePinsHigh(motorMask());
+    stopLatency.record(metricsNowMicros() - due);
+    //Only off if no command came in meanwhile. If one did, its pins may have
+    //been written after the stop, so keep watching them.
+    motorState.compare_exchange_strong(state, state & ~1UL, std::memory_order_acq_rel);
+    fired.store(true, std::memory_order_relaxed);
+    watchdogTrips.add(1);
+  }
+  return NULL;
+}
+
+/*
+emergencyStop:
+  SIGINT and SIGTERM handler. Stops the motors and latches the stop; the
+  handler resets itself, so a second signal ends the program.
+*/
+static void emergencyStop(int) {
+  //metricsNowMicros only calls clock_gettime, which is safe in here
+  unsigned long start = metricsNowMicros();
+  stopped = 1;
+  forcePinsHigh(motorMask());
+  //applyMotors stops the motors again if a command raced with this
+  motorState.fetch_and(~1UL, std::memory_order_relaxed);
+  stopLatency.record(metricsNowMicros() - start);
+}
+
+Result<void> startWatchdog() {
+  const char *inFunction = "startWatchdog";
+  struct sigaction action = {};
+  action.sa_handler = emergencyStop;
+  action.sa_flags = SA_RESETHAND;
+  sigemptyset(&action.sa_mask);
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+  if(running) {
+    return Result<void>();
+  }
+  timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+  itimerspec tick = {};
+  tick.it_interval.tv_nsec = watchdogTickMicros * 1000;
+  tick.it_value = tick.it_interval;
+  if(timerFd < 0 || timerfd_settime(timerFd, 0, &tick, NULL) < 0) {
+    warnMsg(errTimer, inFunction, " - nothing stops the motors if the car stalls.");
+    stopWatchdog();
+    return errTimer;
+  }
+  kickWatchdog();
+  stopDog.store(false, std::memory_order_relaxed);
+  if(pthread_create(&dogThread, NULL, watchMotors, NULL) != 0) {
+    warnMsg(errThread, inFunction, " - could not start the watchdog thread.");
+    stopWatchdog();
+    return errThread;
+  }
+  running = true;
+  return Result<void>();
+}
+
+void stopWatchdog() {
+  if(running) {
+    stopDog.store(true, std::memory_order_relaxed);
+    pthread_join(dogThread, NULL);
+    running = false;
+  }
+  if(timerFd >= 0) {
+    close(timerFd);
+    timerFd = -1;
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include "result.h"
+
+/*
+Watchdog
+---------
+Stops the motors when the control thread stops looking after them: stuck in
+a sleep, blocked writing the log, or gone off down an error path with the
+motors still on. The control loops call kickWatchdog as they go (every
+motor command, moveForward loop and motion tick). A thread woken by a timerfd
+every watchdogTickMicros checks the last kick, and if the motors are on and
+it is more than watchdogPeriodMicros old, forces all four motor pins off.
+So the motors stop at most watchdogPeriodMicros + watchdogTickMicros after
+the last kick, plus however long the thread takes to be scheduled; it runs
+at SCHED_FIFO above the encoder thread to keep that short. The next
+kickWatchdog returns false, so whatever was driving gives up with
+errWatchdog and starts again instead of thinking the car is still moving.
+
+SIGINT and SIGTERM force the motors off from the signal handler itself and
+latch an emergency stop: applyMotors refuses anything but motorsStop after
+it, so the run winds down through its usual error paths and cleans up. A
+second signal ends the program straight away.
+
+Both record how late the stop was in car_stop_latency_us.
+*/
+
+//Longest the control thread may go without a kick while the motors are on
+const long watchdogPeriodMicros = 200000;
+//How often the watchdog thread checks
+const long watchdogTickMicros = 10000;
+
+//Starts the watchdog thread and installs the SIGINT and SIGTERM handlers.
+//Fails with errTimer or errThread if the timer or thread could not be set
+//up; the signal handlers are installed either way.
+Result<void> startWatchdog();
+void stopWatchdog();
+//Called by the control loops to say they are still running. Returns false
+//if the watchdog stopped the motors since the last call.
+bool kickWatchdog();
+//Called by applyMotors with every command it writes, so the watchdog knows
+//whether there is anything to stop. Counts as a kick.
+void watchdogMotors(bool on);
+//Whether SIGINT or SIGTERM has stopped the car
+bool emergencyStopped();
+
+#endif
@@ -0,0 +1,88 @@
+#include <cstdio> //For printf
+#include "junction.h"
+#include "sensors.h"
+
+/*
+junctionTraces
+---------
+Feeds recorded-style sensor traces through the junction history the way
+moveForward does (left, right, then front each loop) and checks what
+junctionFinished and classifyJunction make of them. Exits non-zero if any
+trace comes out wrong.
+*/
+
+//One loop's readings, 1 means the sensor sees a black line like sim scripts
+struct TraceStep {
+  unsigned long micros;
+  int left;
+  int front;
+  int right;
+};
+
+struct Trace {
+  const char *name;
+  const TraceStep *steps;
+  int stepCount;
+  bool finished; //What junctionFinished should say after the last step
+  JunctionType type;
+};
+
+//Corridor to 100 ms, then a wide bar under every sensor that the front is
+//still on 400 ms later
+const TraceStep wideBar[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 1, 1, 1 }, { 300000, 1, 1, 1 }, { 500000, 1, 1, 1 }
+};
+//Across the finish pad and off its far side
+const TraceStep finishPad[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 1, 1, 1 }, { 300000, 1, 1, 1 }, { 500000, 1, 0, 1 }
+};
+//Across a bar too short to be the pad
+const TraceStep shortBar[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 1, 1, 1 }, { 150000, 1, 1, 1 }, { 200000, 1, 0, 1 }
+};
+//Off the end of the maze onto bare floor
+const TraceStep bareFloor[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 0, 0, 0 }, { 300000, 0, 0, 0 }, { 450000, 0, 0, 0 }
+};
+//A crossing, open all round only briefly
+const TraceStep cross[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 0, 0, 0 }, { 110000, 0, 0, 0 }
+};
+//A T, sides open and a line ahead
+const TraceStep tee[] = {
+  { 0, 1, 0, 1 }, { 50000, 1, 0, 1 }, { 100000, 0, 0, 0 }, { 105000, 0, 1, 0 }, { 110000, 0, 1, 0 }
+};
+
+const Trace traces[] = {
+  { "wide bar", wideBar, sizeof(wideBar) / sizeof(wideBar[0]), false, junctionDeadEnd },
+  { "finish pad", finishPad, sizeof(finishPad) / sizeof(finishPad[0]), true, junctionFinish },
+  { "short bar", shortBar, sizeof(shortBar) / sizeof(shortBar[0]), false, junctionNone },
+  { "bare floor", bareFloor, sizeof(bareFloor) / sizeof(bareFloor[0]), true, junctionFinish },
+  { "cross", cross, sizeof(cross) / sizeof(cross[0]), false, junctionCross },
+  { "T", tee, sizeof(tee) / sizeof(tee[0]), false, junctionT }
+};
+
+int main() {
+  int failed = 0;
+  for(const Trace &trace : traces) {
+    JunctionHistory history;
+    junctionReset(history, trace.steps[0].micros, 0);
+    bool finished = false;
+    unsigned long now = 0;
+    for(int i = 0; i < trace.stepCount; i++) {
+      const TraceStep &step = trace.steps[i];
+      now = step.micros;
+      junctionRecord(history, now, irLeftPath, !step.left);
+      junctionRecord(history, now, irRightPath, !step.right);
+      junctionRecord(history, now, irFrontPath, !step.front);
+      finished = junctionFinished(history, now);
+    }
+    JunctionType type = classifyJunction(history, now);
+    bool ok = finished == trace.finished && type == trace.type;
+    printf("%-12s %s (finished %d, %s)\n", trace.name, ok ? "ok" : "FAILED", finished, junctionName(type));
+    if(!ok) {
+      failed ++;
+    }
+  }
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,124 @@
+#include <cstdio> //For printf
+#include <cstring> //For memset
+#include "linearray.h"
+#include "sensors.h"
+
+/*
+lineShape
+---------
+Runs random bars of every size through lineShape (SSE2 on the host) and
+lineShapeWords (the 32 bit word path the MIPS build uses) and checks both
+against a plain loop over the elements. Also checks lineArrayConfigure
+says why a spec was turned down. Exits non-zero on any difference.
+*/
+
+const int barsPerSize = 200000;
+
+static unsigned long long state = 1;
+
+/*
+nextRandom:
+  splitmix64, as in mazeEval
+*/
+static unsigned int nextRandom(unsigned int limit) {
+  unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return (z ^ (z >> 31)) % limit;
+}
+
+/*
+plainShape:
+  One element at a time, with the thirds worked out as in setRegions
+*/
+static void plainShape(const LineSample &sample, LineShape &shape) {
+  int third = sample.count / 3;
+  bool seen[3] = { false, false, false };
+  unsigned long total = 0, weighted = 0;
+  shape.lineMask = 0;
+  shape.width = 0;
+  for(int i = 0; i < sample.count; i++) {
+    if(sample.levels[i] <= lineThreshold) {
+      continue;
+    }
+    shape.lineMask |= 1U << i;
+    shape.width ++;
+    total += sample.levels[i];
+    weighted += sample.levels[i] * i;
+    seen[i < third ? 1 : i >= sample.count - third ? 2 : 0] = true;
+  }
+  shape.centroid = total ? (int)(weighted * 256 / total) : -1;
+  shape.paths = (seen[0] ? 0 : irFrontPath) | (seen[1] ? 0 : irLeftPath) | (seen[2] ? 0 : irRightPath);
+}
+
+static bool sameShape(const LineShape &first, const LineShape &second) {
+  return first.lineMask == second.lineMask && first.width == second.width && first.centroid == second.centroid && first.paths == second.paths;
+}
+
+struct SpecCase {
+  const char *spec;
+  ErrorCode error;
+};
+
+const SpecCase specs[] = {
+  { "analog:8:/dev/ttyS1", errNone },
+  { "analog:4:/dev/ttyS1", errBadParameter },
+  { "analog:17:/dev/ttyS1", errBadParameter },
+  { "serial:8", errBadParameter },
+  { "gpio:20,21,22,23,24", errNone },
+  { "gpio:20,21,22", errBadParameter },
+  { "gpio:20,21,22,23,x", errBadParameter },
+  { "gpio:20,21,21,22,23", errBadParameter },
+  { "gpio:20,21,0,22,23", errPinInUse }, //A motor on every board
+};
+
+int main() {
+  int failures = 0;
+  for(unsigned int i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+    Result<void> configured = lineArrayConfigure(specs[i].spec);
+    bool right = configured.getError() == specs[i].error;
+    printf("%s %s\n", specs[i].spec, right ? "ok" : "FAILED");
+    failures += !right;
+  }
+  LineSample sample;
+  LineShape plain, wide, words;
+  for(int count = lineMinSensors; count <= lineMaxSensors; count++) {
+    char spec[32];
+    snprintf(spec, sizeof(spec), "analog:%d:sim", count);
+    if(!lineArrayConfigure(spec).ok()) {
+      printf("%d elements: could not configure FAILED\n", count);
+      failures ++;
+      continue;
+    }
+    int wrong = 0;
+    for(int bar = 0; bar < barsPerSize; bar++) {
+      memset(sample.levels, 0, sizeof(sample.levels));
+      sample.count = count;
+      //Mostly a band of line over floor noise, sometimes anything at all
+      bool anything = !nextRandom(4);
+      int first = nextRandom(count);
+      int last = first + nextRandom(count - first);
+      for(int i = 0; i < count; i++) {
+        if(anything) {
+          sample.levels[i] = nextRandom(lineLevelMax + 1);
+        }
+        else if(i >= first && i <= last) {
+          sample.levels[i] = lineLevelMax - nextRandom(40);
+        }
+        else {
+          sample.levels[i] = nextRandom(40);
+        }
+      }
+      plainShape(sample, plain);
+      lineShape(sample, wide);
+      lineShapeWords(sample, words);
+      if(!sameShape(plain, wide) || !sameShape(plain, words)) {
+        wrong ++;
+      }
+    }
+    printf("%d elements %s\n", count, wrong ? "FAILED" : "ok");
+    failures += wrong ? 1 : 0;
+  }
+  lineArrayClose();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,164 @@
+#include <cstdio> //For printf
+#include <cstring> //For memset
+#include "maze.h"
+#include "sensors.h"
+#include "frontier.h"
+#include "loopclose.h"
+
+/*
+loopFree
+---------
+Drives the navigation code (frontierArrive, loopArrive and Tremaux, in the
+order mazeEval and intersection use them) through perfect mazes with
+perfect sensors. With only one path between any two cells there is no loop
+to close, so every closure loopArrive reports merged two different places.
+Exits non-zero if there is any.
+*/
+
+const int mazeWidth = 7;
+const int mazeHeight = 8;
+const int mazeCount = 5000;
+const int stepX[totalDirections] = { 0, 1, 0, -1 };
+const int stepY[totalDirections] = { 1, 0, -1, 0 };
+
+//Open sides of each cell, bit per direction in maze.h order
+static unsigned char open[mazeWidth][mazeHeight];
+
+/*
+nextRandom:
+  splitmix64, as in mazeEval
+*/
+static unsigned long long nextRandom(unsigned long long &state) {
+  unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+generateMaze:
+  Depth first backtracker from the bottom middle cell, exit on the top row
+*/
+static void generateMaze(unsigned long long &state) {
+  static bool visited[mazeWidth][mazeHeight];
+  static int stack[mazeWidth * mazeHeight][2];
+  memset(open, 0, sizeof(open));
+  memset(visited, 0, sizeof(visited));
+  int depth = 0;
+  stack[depth][0] = mazeWidth / 2;
+  stack[depth][1] = 0;
+  visited[mazeWidth / 2][0] = true;
+  depth ++;
+  while(depth) {
+    int x = stack[depth - 1][0];
+    int y = stack[depth - 1][1];
+    int choices[totalDirections];
+    int count = 0;
+    for(int direction = 0; direction < totalDirections; direction++) {
+      int nextX = x + stepX[direction];
+      int nextY = y + stepY[direction];
+      if(nextX >= 0 && nextX < mazeWidth && nextY >= 0 && nextY < mazeHeight && !visited[nextX][nextY]) {
+        choices[count++] = direction;
+      }
+    }
+    if(!count) {
+      depth --;
+      continue;
+    }
+    int direction = choices[nextRandom(state) % count];
+    open[x][y] |= 1 << direction;
+    x += stepX[direction];
+    y += stepY[direction];
+    open[x][y] |= 1 << ((direction + 2) % totalDirections);
+    visited[x][y] = true;
+    stack[depth][0] = x;
+    stack[depth][1] = y;
+    depth ++;
+  }
+  open[mazeWidth / 2][0] |= 1 << 2;
+  open[nextRandom(state) % mazeWidth][mazeHeight - 1] |= 1 << 0;
+}
+
+static unsigned int sense(int x, int y, int heading) {
+  unsigned int paths = 0;
+  if(open[x][y] & (1 << heading)) {
+    paths |= irFrontPath;
+  }
+  if(open[x][y] & (1 << (heading + 3) % totalDirections)) {
+    paths |= irLeftPath;
+  }
+  if(open[x][y] & (1 << (heading + 1) % totalDirections)) {
+    paths |= irRightPath;
+  }
+  return paths;
+}
+
+/*
+closuresIn:
+  Loops closed on the way through the current maze, until it is solved or
+  the navigation gives up
+*/
+static int closuresIn() {
+  static MazeMap marks;
+  static FrontierIndex frontier;
+  static LoopIndex loops;
+  mapReset(marks);
+  int spot[2] = { startWidth, 0 };
+  mapSet(marks, spot[0], spot[1], 2);
+  frontierReset(frontier);
+  loopReset(loops);
+  int x = mazeWidth / 2;
+  int y = 0;
+  int heading = 0;
+  int closures = 0;
+  for(unsigned long moves = 0; moves < 50UL * mazeWidth * mazeHeight; ) {
+    unsigned int paths = sense(x, y, heading);
+    if(paths & irFrontPath) {
+      x += stepX[heading];
+      y += stepY[heading];
+      moves ++;
+      if(y < 0 || y >= mazeHeight) {
+        break;
+      }
+      paths = sense(x, y, heading);
+      if(paths == irFrontPath) {
+        continue;
+      }
+    }
+    frontierArrive(frontier, heading, paths, moves);
+    if(loopArrive(loops, frontier, heading, spot) >= 0) {
+      closures ++;
+    }
+    int routed = frontierBearing(frontier, heading, paths);
+    int bearing = tremauxDecide(marks, spot, heading, paths, routed);
+    if(bearing < 0) {
+      break;
+    }
+    if(bearing == 3 && routed < 0) {
+      frontierPlan(frontier);
+    }
+    if(bearing) {
+      heading = turnedDirection(heading, bearing == 3 ? 0 : bearing);
+    }
+    frontierLeave(frontier, heading, moves);
+    if(tremauxArrive(marks, spot, heading, bearing) < 0) {
+      break;
+    }
+  }
+  return closures;
+}
+
+int main() {
+  unsigned long long state = 1;
+  int failures = 0;
+  for(int maze = 0; maze < mazeCount; maze++) {
+    generateMaze(state);
+    int closures = closuresIn();
+    if(closures) {
+      printf("maze %d closed %d loops FAILED\n", maze, closures);
+      failures ++;
+    }
+  }
+  printf("%d perfect mazes %s\n", mazeCount, failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
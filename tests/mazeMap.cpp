@@ -0,0 +1,84 @@
+#include <cstdio> //For printf
+#include "mazemap.h"
+
+/*
+mazeMap
+---------
+Fills maps with random marks through mapSet and mapMark, keeping the same
+marks in a plain int array, and checks mapGet reads every spot back the
+same. Then checks mapReset (SSE2 on the host) leaves nothing behind. Exits
+non-zero on any difference.
+*/
+
+const int mapCount = 2000;
+const int changesPerMap = 600;
+
+static unsigned long long state = 1;
+
+/*
+nextRandom:
+  splitmix64, as in mazeEval
+*/
+static unsigned int nextRandom(unsigned int limit) {
+  unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return (z ^ (z >> 31)) % limit;
+}
+
+/*
+differences:
+  Spots where map doesn't hold what plain does
+*/
+static int differences(const MazeMap &map, int plain[mapWidth][mapHeight]) {
+  int count = 0;
+  for(int x = 0; x < mapWidth; x++) {
+    for(int y = 0; y < mapHeight; y++) {
+      if(mapGet(map, x, y) != plain[x][y]) {
+        count ++;
+      }
+    }
+  }
+  return count;
+}
+
+int main() {
+  static MazeMap map;
+  static int plain[mapWidth][mapHeight];
+  int failures = 0;
+  for(int round = 0; round < mapCount; round++) {
+    mapReset(map);
+    for(int x = 0; x < mapWidth; x++) {
+      for(int y = 0; y < mapHeight; y++) {
+        plain[x][y] = 0;
+      }
+    }
+    for(int change = 0; change < changesPerMap; change++) {
+      int x = nextRandom(mapWidth);
+      int y = nextRandom(mapHeight);
+      int marks = nextRandom(mapMostMarks + 1);
+      if(nextRandom(2)) {
+        mapSet(map, x, y, marks);
+        plain[x][y] = marks;
+      }
+      else {
+        mapMark(map, x, y, marks);
+        plain[x][y] = plain[x][y] + marks > mapMostMarks ? mapMostMarks : plain[x][y] + marks;
+      }
+    }
+    int wrong = differences(map, plain);
+    if(wrong) {
+      printf("map %d: %d spots FAILED\n", round, wrong);
+      failures ++;
+    }
+    mapReset(map);
+    for(int i = 0; i < mapWords; i++) {
+      if(map.words[i]) {
+        printf("map %d: word %d left after mapReset FAILED\n", round, i);
+        failures ++;
+      }
+    }
+  }
+  printf("%d random maps %s\n", mapCount, failures ? "FAILED" : "ok");
+  return failures ? 1 : 0;
+}
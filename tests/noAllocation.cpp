@@ -0,0 +1,88 @@
+#include <cstdio> //For printf
+#include <cstdlib> //For malloc and setenv
+#include <atomic>
+#include <new>
+#include "motors.h"
+#include "maze.h"
+#include "logging.h"
+#include "tuning.h"
+
+/*
+noAllocation
+---------
+Drives carMaze's moveForward and intersection loop through a simulator
+script (the first argument, sim/train.txt from ctest) with operator new
+counting every call, and fails if anything on the way allocated. The loop
+is meant to run on fixed arrays and globals only, so a heap allocation
+there is a page fault or a lock the car can't afford.
+*/
+
+static std::atomic<bool> counting(false);
+static std::atomic<long> allocations(0);
+
+void *operator new(std::size_t size) {
+  if(counting.load(std::memory_order_relaxed)) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  void *memory = malloc(size ? size : 1);
+  if(!memory) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+void *operator new[](std::size_t size) {
+  return operator new(size);
+}
+void operator delete(void *memory) noexcept {
+  free(memory);
+}
+void operator delete[](void *memory) noexcept {
+  free(memory);
+}
+void operator delete(void *memory, std::size_t) noexcept {
+  free(memory);
+}
+void operator delete[](void *memory, std::size_t) noexcept {
+  free(memory);
+}
+
+int main(int argc, char **argv) {
+  if(argc < 2) {
+    fprintf(stderr, "usage: noAllocation <simulator script>\n");
+    return 2;
+  }
+  setenv("OMEGA_SIM_SCRIPT", argv[1], 1);
+  resetMaze();
+  if(!initialize().ok()) {
+    fprintf(stderr, "could not set up the pins\n");
+    return 2;
+  }
+  //The first motor command opens the log file, do that before counting
+  startLog();
+  int currentDirection = 0, j = 0, moves = 0;
+  bool done = false;
+  counting = true;
+  do {
+    Result<bool> moved = moveForward(true);
+    moves ++;
+    if(!moved.ok()) {
+      j ++;
+    }
+    else if(moved.get()) {
+      done = true;
+    }
+    else {
+      Result<int> newDirection = intersection(currentDirection);
+      if(newDirection.ok()) {
+        currentDirection = newDirection.get();
+        j = 0;
+      }
+      else {
+        j ++;
+      }
+    }
+  } while(j < tuning().maxLength && !done);
+  counting = false;
+  printf("%d moves, %s, %ld allocations\n", moves, done ? "finished" : "gave up", allocations.load());
+  return done && !allocations ? 0 : 1;
+}
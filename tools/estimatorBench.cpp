@@ -0,0 +1,72 @@
+#include <cstdio> //For printf
+#include <cstdlib> //For strtoul
+#include <unistd.h> //For getopt
+#include <chrono> //For timing the updates
+#include "estimator.h"
+#include "motion.h"
+
+/*
+estimatorBench
+---------------
+Host only. Times estimatorPredict, the fixed point update runProfile and
+driveUpdate make every control tick, over a repeating drive: straights
+at half and full duty, a right turn and a stop. Reports nanoseconds per
+update.
+
+  estimatorBench [-n updates] [-d tick micros]
+
+The wheel encoders aren't running on the host, so this is the prediction
+on its own, without the encoder measurements.
+*/
+
+//One leg of the repeating drive
+struct Leg {
+  MotorCommand command;
+  int duty;
+  int ticks;
+};
+const Leg legs[] = {
+  { motorsForward, pwmSteps / 2, 50 },
+  { motorsForward, pwmSteps, 200 },
+  { motorsTurnRight, pwmSteps, 100 },
+  { motorsStop, 0, 50 }
+};
+const int legCount = sizeof(legs) / sizeof(legs[0]);
+
+int main(int argc, char **argv) {
+  unsigned long updates = 10000000;
+  long tickMicros = 1000;
+  int option;
+  while((option = getopt(argc, argv, "n:d:")) != -1) {
+    switch(option) {
+      case 'n':
+        updates = strtoul(optarg, NULL, 10);
+        break;
+      case 'd':
+        tickMicros = atol(optarg);
+        break;
+      default:
+        fprintf(stderr, "usage: estimatorBench [-n updates] [-d tick micros]\n");
+        return 2;
+    }
+  }
+  estimatorReset(0);
+  int leg = 0, tick = 0;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(unsigned long i = 0; i < updates; i++) {
+    if(!tick && legs[leg].command == motorsTurnRight) {
+      estimatorStartTurn(2);
+    }
+    estimatorPredict(legs[leg].command, legs[leg].duty, tickMicros);
+    if(++tick == legs[leg].ticks) {
+      tick = 0;
+      leg = (leg + 1) % legCount;
+    }
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  printf("%lu updates in %.3f s, %.1f ns per update\n", updates, seconds, updates ? seconds * 1e9 / updates : 0.0);
+  //Printing the result keeps the updates from being optimized away
+  printf("ended at %ld mm, %ld degrees\n", estimatedDistanceMm(), estimatedHeadingDegrees());
+  return 0;
+}
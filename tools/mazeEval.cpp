@@ -0,0 +1,392 @@
+#include <cstdio> //For printf
+#include <cstdlib> //For strtoul
+#include <cstring> //For memset
+#include <unistd.h> //For getopt
+#include <chrono> //For timing the whole run
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "maze.h"
+#include "sensors.h"
+#include "frontier.h"
+#include "loopclose.h"
+
+/*
+mazeEval
+---------
+Runs the navigation logic of carMaze (tremauxDecide, tremauxArrive and
+turnedDirection from maze.h, the same code intersection uses) through
+thousands of random mazes on the host, with a simulated car whose sensors
+can misread. Reports how many mazes were solved, how long the paths were and
+how fast decisions are made.
+
+  mazeEval [-n mazes] [-s seed] [-x width] [-y height] [-l loop %] [-e noise %] [-t threads] [-p]
+
+Mazes start perfect (one path between any two cells), -l knocks down that
+percentage of the remaining inner walls to make loops. -e is the chance of
+each sensor reading being wrong at an intersection. Every maze gets its own
+random numbers from the seed and its index, so results don't depend on the
+number of threads. -p turns off routing to the frontier (see frontier.h) to
+compare with plain Tremaux.
+*/
+
+//Open sides of a cell, same order as directions in maze.h
+const unsigned char openNorth = 1 << 0;
+const unsigned char openEast = 1 << 1;
+const unsigned char openSouth = 1 << 2;
+const unsigned char openWest = 1 << 3;
+const int maxCells = 32;
+//Mazes handed out at a time, and stolen at a time
+const int chunkMazes = 16;
+
+struct Settings {
+  unsigned long mazes = 10000;
+  unsigned long long seed = 1;
+  int width = 7;
+  int height = 8;
+  int loopPercent = 0;
+  int noisePercent = 0;
+  int threads = 0;
+  bool routing = true;
+};
+
+struct Maze {
+  int width;
+  int height;
+  int exitX;
+  unsigned char open[maxCells][maxCells];
+};
+
+//Totals for a group of mazes, only whole numbers so they add up the same in
+//any order
+struct Tally {
+  unsigned long mazes = 0;
+  unsigned long solved = 0;
+  unsigned long offMap = 0; //Ran off allPaths
+  unsigned long stuck = 0; //Tremaux had no answer
+  unsigned long tooLong = 0; //Gave up
+  unsigned long solvedMoves = 0; //Cells driven in solved mazes
+  unsigned long decisions = 0;
+  unsigned long loopClosures = 0;
+};
+
+/*
+Rng:
+  splitmix64, small and the same everywhere
+*/
+struct Rng {
+  unsigned long long state;
+  unsigned long long next() {
+    unsigned long long z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+  int below(int limit) {
+    return next() % limit;
+  }
+  bool chance(int percent) {
+    return below(100) < percent;
+  }
+};
+
+const int stepX[totalDirections] = { 0, 1, 0, -1 };
+const int stepY[totalDirections] = { 1, 0, -1, 0 };
+
+/*
+carve:
+  Opens the wall between a cell and the one in direction
+*/
+static void carve(Maze &maze, int x, int y, int direction) {
+  maze.open[x][y] |= 1 << direction;
+  maze.open[x + stepX[direction]][y + stepY[direction]] |= 1 << ((direction + 2) % totalDirections);
+}
+
+/*
+generateMaze:
+  Depth first backtracker for a perfect maze, then loops knocked in. The
+  entrance is the bottom middle cell, the exit somewhere on the top row.
+*/
+static void generateMaze(Maze &maze, const Settings &settings, Rng &rng) {
+  maze.width = settings.width;
+  maze.height = settings.height;
+  memset(maze.open, 0, sizeof(maze.open));
+  static thread_local bool visited[maxCells][maxCells];
+  static thread_local int stack[maxCells * maxCells][2];
+  memset(visited, 0, sizeof(visited));
+  int depth = 0;
+  stack[depth][0] = maze.width / 2;
+  stack[depth][1] = 0;
+  visited[maze.width / 2][0] = true;
+  depth ++;
+  while(depth) {
+    int x = stack[depth - 1][0];
+    int y = stack[depth - 1][1];
+    int choices[totalDirections];
+    int count = 0;
+    for(int direction = 0; direction < totalDirections; direction++) {
+      int nextX = x + stepX[direction];
+      int nextY = y + stepY[direction];
+      if(nextX >= 0 && nextX < maze.width && nextY >= 0 && nextY < maze.height && !visited[nextX][nextY]) {
+        choices[count++] = direction;
+      }
+    }
+    if(!count) {
+      depth --;
+      continue;
+    }
+    int direction = choices[rng.below(count)];
+    carve(maze, x, y, direction);
+    x += stepX[direction];
+    y += stepY[direction];
+    visited[x][y] = true;
+    stack[depth][0] = x;
+    stack[depth][1] = y;
+    depth ++;
+  }
+  //Loops: knock down walls to the north and east
+  for(int x = 0; x < maze.width; x++) {
+    for(int y = 0; y < maze.height; y++) {
+      if(y + 1 < maze.height && !(maze.open[x][y] & openNorth) && rng.chance(settings.loopPercent)) {
+        carve(maze, x, y, 0);
+      }
+      if(x + 1 < maze.width && !(maze.open[x][y] & openEast) && rng.chance(settings.loopPercent)) {
+        carve(maze, x, y, 1);
+      }
+    }
+  }
+  maze.open[maze.width / 2][0] |= openSouth;
+  maze.exitX = rng.below(maze.width);
+  maze.open[maze.exitX][maze.height - 1] |= openNorth;
+}
+
+/*
+sense:
+  What the sensors of a car facing heading would report in a cell, as
+  checkAllIR bits
+*/
+static unsigned int sense(const Maze &maze, int x, int y, int heading) {
+  unsigned char open = maze.open[x][y];
+  unsigned int paths = 0;
+  if(open & (1 << heading)) {
+    paths |= irFrontPath;
+  }
+  if(open & (1 << (heading + 3) % totalDirections)) {
+    paths |= irLeftPath;
+  }
+  if(open & (1 << (heading + 1) % totalDirections)) {
+    paths |= irRightPath;
+  }
+  return paths;
+}
+
+/*
+runMaze:
+  Drives the simulated car through one maze the way carMaze's main loop
+  does: forward to the next junction, then intersection's bookkeeping
+*/
+static void runMaze(const Settings &settings, unsigned long index, Tally &tally) {
+  Rng rng = { settings.seed ^ (index * 0xd1b54a32d192ed03ULL) };
+  Maze maze;
+  generateMaze(maze, settings, rng);
+
+  //Same start as resetMaze
+  MazeMap marks;
+  mapReset(marks);
+  int spot[2] = { startWidth, 0 };
+  mapSet(marks, spot[0], spot[1], 2);
+  FrontierIndex frontier;
+  frontierReset(frontier);
+  LoopIndex loops;
+  loopReset(loops);
+
+  int x = maze.width / 2;
+  int y = 0;
+  int heading = 0;
+  unsigned long moves = 0;
+  unsigned long moveLimit = 50UL * maze.width * maze.height;
+  tally.mazes ++;
+  while(moves < moveLimit) {
+    //moveForward: drive on until something other than a plain corridor
+    unsigned int paths = sense(maze, x, y, heading);
+    if(paths & irFrontPath) {
+      x += stepX[heading];
+      y += stepY[heading];
+      moves ++;
+      if(y >= maze.height) {
+        tally.solved ++;
+        tally.solvedMoves += moves;
+        return;
+      }
+      if(y < 0) {
+        //Back out of the entrance
+        tally.stuck ++;
+        return;
+      }
+      paths = sense(maze, x, y, heading);
+      if(paths == irFrontPath) {
+        continue;
+      }
+    }
+    //intersection, with every sensor possibly misread
+    for(unsigned int bit = irFrontPath; bit <= irRightPath; bit <<= 1) {
+      if(rng.chance(settings.noisePercent)) {
+        paths ^= bit;
+      }
+    }
+    tally.decisions ++;
+    //Distances in the frontier index are cells driven
+    frontierArrive(frontier, heading, paths, moves);
+    if(settings.routing && loopArrive(loops, frontier, heading, spot) >= 0) {
+      tally.loopClosures ++;
+    }
+    int routed = settings.routing ? frontierBearing(frontier, heading, paths) : -1;
+    int bearing = tremauxDecide(marks, spot, heading, paths, routed);
+    if(bearing < 0) {
+      if(bearing == -errOffMap) {
+        tally.offMap ++;
+      }
+      else {
+        tally.stuck ++;
+      }
+      return;
+    }
+    if(bearing == 3 && routed < 0 && settings.routing) {
+      frontierPlan(frontier);
+    }
+    if(bearing) {
+      heading = turnedDirection(heading, bearing == 3 ? 0 : bearing);
+    }
+    frontierLeave(frontier, heading, moves);
+    if(tremauxArrive(marks, spot, heading, bearing) < 0) {
+      tally.offMap ++;
+      return;
+    }
+  }
+  tally.tooLong ++;
+}
+
+/*
+WorkQueue:
+  Chunks of maze indexes for one worker. The owner takes from the back,
+  others steal from the front.
+*/
+struct WorkQueue {
+  std::mutex lock;
+  std::deque<unsigned long> chunks;
+};
+
+static bool takeChunk(std::vector<WorkQueue> &queues, int worker, unsigned long &chunk) {
+  {
+    std::lock_guard<std::mutex> guard(queues[worker].lock);
+    if(!queues[worker].chunks.empty()) {
+      chunk = queues[worker].chunks.back();
+      queues[worker].chunks.pop_back();
+      return true;
+    }
+  }
+  for(size_t offset = 1; offset < queues.size(); offset++) {
+    WorkQueue &victim = queues[(worker + offset) % queues.size()];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if(!victim.chunks.empty()) {
+      chunk = victim.chunks.front();
+      victim.chunks.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+static void worker(const Settings &settings, std::vector<WorkQueue> &queues, int id, Tally &tally) {
+  unsigned long chunk;
+  while(takeChunk(queues, id, chunk)) {
+    unsigned long end = (chunk + 1) * chunkMazes;
+    if(end > settings.mazes) {
+      end = settings.mazes;
+    }
+    for(unsigned long index = chunk * chunkMazes; index < end; index++) {
+      runMaze(settings, index, tally);
+    }
+  }
+}
+
+int main(int argc, char **argv) {
+  Settings settings;
+  int option;
+  while((option = getopt(argc, argv, "n:s:x:y:l:e:t:p")) != -1) {
+    switch(option) {
+      case 'n':
+        settings.mazes = strtoul(optarg, NULL, 10);
+        break;
+      case 's':
+        settings.seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'x':
+        settings.width = atoi(optarg);
+        break;
+      case 'y':
+        settings.height = atoi(optarg);
+        break;
+      case 'l':
+        settings.loopPercent = atoi(optarg);
+        break;
+      case 'e':
+        settings.noisePercent = atoi(optarg);
+        break;
+      case 't':
+        settings.threads = atoi(optarg);
+        break;
+      case 'p':
+        settings.routing = false;
+        break;
+      default:
+        fprintf(stderr, "usage: %s [-n mazes] [-s seed] [-x width] [-y height] [-l loop %%] [-e noise %%] [-t threads] [-p]\n", argv[0]);
+        return 1;
+    }
+  }
+  if(settings.width < 2 || settings.width > maxCells || settings.height < 2 || settings.height > maxCells) {
+    fprintf(stderr, "width and height must be 2 to %d\n", maxCells);
+    return 1;
+  }
+  if(settings.threads <= 0) {
+    settings.threads = std::thread::hardware_concurrency();
+    if(settings.threads <= 0) {
+      settings.threads = 1;
+    }
+  }
+
+  //Deal the chunks out round robin, stealing evens out the rest
+  std::vector<WorkQueue> queues(settings.threads);
+  unsigned long chunks = (settings.mazes + chunkMazes - 1) / chunkMazes;
+  for(unsigned long chunk = 0; chunk < chunks; chunk++) {
+    queues[chunk % settings.threads].chunks.push_back(chunk);
+  }
+  std::vector<Tally> tallies(settings.threads);
+  std::vector<std::thread> workers;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int id = 0; id < settings.threads; id++) {
+    workers.emplace_back(worker, std::cref(settings), std::ref(queues), id, std::ref(tallies[id]));
+  }
+  for(std::thread &thread : workers) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  Tally total;
+  for(const Tally &tally : tallies) {
+    total.mazes += tally.mazes;
+    total.solved += tally.solved;
+    total.offMap += tally.offMap;
+    total.stuck += tally.stuck;
+    total.tooLong += tally.tooLong;
+    total.solvedMoves += tally.solvedMoves;
+    total.decisions += tally.decisions;
+    total.loopClosures += tally.loopClosures;
+  }
+  printf("mazes %lu (%dx%d, %d%% loops, %d%% noise, seed %llu, %d threads%s)\n", total.mazes, settings.width, settings.height, settings.loopPercent, settings.noisePercent, settings.seed, settings.threads, settings.routing ? "" : ", no routing");
+  printf("solved %lu (%.1f%%), off the map %lu, stuck %lu, gave up %lu\n", total.solved, total.mazes ? 100.0 * total.solved / total.mazes : 0.0, total.offMap, total.stuck, total.tooLong);
+  printf("mean path length %.1f cells\n", total.solved ? (double)total.solvedMoves / total.solved : 0.0);
+  printf("decisions %lu, %.0f per second, loops closed %lu\n", total.decisions, seconds > 0 ? total.decisions / seconds : 0.0, total.loopClosures);
+  return 0;
+}
@@ -0,0 +1,30 @@
+#!/bin/sh
+#Prints the size of each binary given and, if it can run on this machine,
+#the time to the first motor command and to finish the shortest simulator run.
+#Usage: size-report.sh <binary>...
+
+script=$(mktemp)
+rundir=$(mktemp -d)
+trap 'rm -rf "$script" "$rundir"' EXIT
+#Lines on every side right away, so the car only drives to the end of the maze
+echo "1 1 1 1" > "$script"
+
+for binary in "$@"; do
+  name=$(basename "$binary")
+  bytes=$(wc -c < "$binary")
+  echo "$name: $bytes bytes"
+  if command -v size > /dev/null 2>&1; then
+    size "$binary" | tail -n 1 | awk '{ print "  text " $1 ", data " $2 ", bss " $3 }'
+  fi
+  if [ "$name" = "carMaze" ]; then
+    start=$(date +%s%N)
+    if (cd "$rundir" && OMEGA_SIM_SCRIPT="$script" "$binary" > /dev/null 2>&1); then
+      end=$(date +%s%N)
+      echo "  simulator run to end of maze: $(( (end - start) / 1000 )) us"
+      grep -h "Time to first motor command" "$rundir/log.txt" | sed 's/^/  /'
+      rm -f "$rundir/log.txt"
+    else
+      echo "  could not run on this machine"
+    fi
+  fi
+done